@@ -17,10 +17,11 @@ namespace bsccs {
 //}
 
 AbstractModelSpecifics::AbstractModelSpecifics(const ModelData& input)
-	: oY(input.getYVectorRef()), oZ(input.getZVectorRef()),
+	: modelData(input), oY(input.getYVectorRef()), oZ(input.getZVectorRef()),
 	  oPid(input.getPidVectorRef()),
 	  hY(const_cast<real*>(oY.data())), hZ(const_cast<real*>(oZ.data())),
-	  hPid(const_cast<int*>(oPid.data()))
+	  hPid(const_cast<int*>(oPid.data())), nThreads(1),
+	  hessianCrossTermCache(defaultCrossTermCacheBytes)
 	  {
 	// Do nothing
 }
@@ -29,19 +30,20 @@ AbstractModelSpecifics::~AbstractModelSpecifics() {
 	if (hXjX) {
 		free(hXjX);
 	}
-	for (HessianSparseMap::iterator it = hessianSparseCrossTerms.begin();
-			it != hessianSparseCrossTerms.end(); ++it) {
-		delete it->second;
-	}
 }
 
 void AbstractModelSpecifics::makeDirty(void) {
 	hessianCrossTerms.erase(hessianCrossTerms.begin(), hessianCrossTerms.end());
 
-	for (HessianSparseMap::iterator it = hessianSparseCrossTerms.begin();
-			it != hessianSparseCrossTerms.end(); ++it) {
-		delete it->second;
-	}
+	hessianCrossTermCache.clear();
+}
+
+void AbstractModelSpecifics::setThreads(int threads) {
+	nThreads = threads;
+}
+
+void AbstractModelSpecifics::setCrossTermCacheBudget(size_t bytes) {
+	hessianCrossTermCache.setBudget(bytes);
 }
 
 void AbstractModelSpecifics::initialize(
@@ -54,7 +56,7 @@ void AbstractModelSpecifics::initialize(
 		real* iDenomPid,
 //		int* iNEvents,
 		real* iXjY,
-		std::vector<std::vector<int>* >* iSparseIndices,
+		SparseIndices* iSparseIndices,
 		int* iPid_unused,
 		real* iOffsExpXBeta,
 		real* iXBeta,
@@ -71,6 +73,13 @@ void AbstractModelSpecifics::initialize(
 	numerPid2 = iNumerPid2;
 	denomPid = iDenomPid;
 
+	// Per-stratum column lists; rows that are their own strata need none.  Engines built
+	// inside driver workers are set to one thread, so they build serially
+	if (allocateSparseIndices()) {
+		iSparseIndices->build(*iXI, hPid, nThreads);
+	} else {
+		iSparseIndices->clear(J);
+	}
 	sparseIndices = iSparseIndices;
 
 //	hPid = iPid;
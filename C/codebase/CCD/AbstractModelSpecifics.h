@@ -12,6 +12,9 @@
 #include <cmath>
 #include <map>
 
+#include "CrossTermCache.h"
+#include "SparseIndices.h"
+
 namespace bsccs {
 
 class CompressedDataMatrix;  // forward declaration
@@ -46,7 +49,7 @@ public:
 			real* iNumerPid2,
 			real* iDenomPid,
 			real* iXjY,
-			std::vector<std::vector<int>* >* iSparseIndices,
+			SparseIndices* iSparseIndices,
 			int* iPid,
 			real* iOffsExpXBeta,
 			real* iXBeta,
@@ -64,6 +67,15 @@ public:
 	virtual void computeFisherInformation(int indexOne, int indexTwo,
 			double *oinfo, bool useWeights) = 0; // pure virtual
 
+	/**
+	 * Fills groups with the rows (or strata, for models with strata cross-terms) through which
+	 * covariate index enters the Fisher information; pairs with disjoint groups have zero
+	 * information.  Returns false, leaving groups empty, when index reaches all of them.
+	 * Also caches any per-covariate cross-terms.  Safe to call from several threads, as is
+	 * computeFisherInformation() without weights.
+	 */
+	virtual bool getFisherInformationGroups(int index, std::vector<int>* groups) = 0; // pure virtual
+
 	virtual void updateXBeta(real realDelta, int index, bool useWeights) = 0; // pure virtual
 
 	virtual void computeRemainingStatistics(bool useWeights) = 0; // pure virtual
@@ -80,6 +92,18 @@ public:
 
     virtual void makeDirty();
 
+	void setThreads(int threads);
+
+	// Memory budget for the cross-terms of models with strata, in bytes
+	void setCrossTermCacheBudget(size_t bytes);
+
+	const static size_t defaultCrossTermCacheBytes = 256 * 1024 * 1024;
+
+	virtual AbstractModelSpecifics* clone() const = 0; // pure virtual
+
+	// Same model over other data, e.g. a row subset of this data
+	virtual AbstractModelSpecifics* clone(const ModelData& data) const = 0; // pure virtual
+
 //	virtual void sortPid(bool useCrossValidation) = 0; // pure virtual
 
 protected:
@@ -88,6 +112,8 @@ protected:
 
 	virtual bool allocateXjX(void) = 0; // pure virtual
 
+	virtual bool allocateSparseIndices(void) = 0; // pure virtual
+
 	template <class T>
 	void fillVector(T* vector, const int length, const T& value) {
 		for (int i = 0; i < length; i++) {
@@ -100,13 +126,13 @@ protected:
 		fillVector(vector, length, T());
 	}
 
+	const ModelData& modelData;
+
 	const std::vector<real>& oY;
 	const std::vector<real>& oZ;
 	const std::vector<int>& oPid;
 
 	std::vector<real> accDenomPid;
-	std::vector<real> accNumerPid;
-	std::vector<real> accNumerPid2;
 
 	// TODO Currently constructed in CyclicCoordinateDescent, but should be encapsulated here
 	CompressedDataMatrix* hXI; // K-by-J-indicator matrix
@@ -127,6 +153,8 @@ protected:
 	int K; // Number of exposure levels
 	int J; // Number of drugs
 
+	int nThreads; // For scans over all K rows
+
 	real* expXBeta;
 	real* offsExpXBeta;
 	real* denomPid;
@@ -137,13 +165,12 @@ protected:
 	real* hXjX;
 	real logLikelihoodFixedTerm;
 
-	std::vector<std::vector<int>* > *sparseIndices;
+	const SparseIndices* sparseIndices;
 
 	typedef std::map<int, std::vector<real> > HessianMap;
 	HessianMap hessianCrossTerms;
 
-	typedef std::map<int, CompressedDataColumn* > HessianSparseMap;
-	HessianSparseMap hessianSparseCrossTerms;
+	CrossTermCache hessianCrossTermCache;
 };
 
 } // namespace
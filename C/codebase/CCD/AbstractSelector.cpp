@@ -40,6 +40,12 @@ AbstractSelector::AbstractSelector(
 	}
 }
 
+AbstractSelector::AbstractSelector(const AbstractSelector& copy) :
+		ids(new std::vector<int>(*copy.ids)), type(copy.type), seed(copy.seed), K(copy.K),
+		N(copy.N), deterministic(copy.deterministic) {
+	// Do nothing
+}
+
 AbstractSelector::~AbstractSelector() {
 	if (ids) {
 		delete ids;
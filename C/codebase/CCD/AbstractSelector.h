@@ -30,6 +30,8 @@ public:
 			SelectorType inType,
 			long inSeed);
 
+	AbstractSelector(const AbstractSelector& copy);
+
 	virtual ~AbstractSelector();
 
 	virtual void permute() = 0; // pure virtual
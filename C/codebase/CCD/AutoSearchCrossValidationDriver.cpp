@@ -65,7 +65,9 @@ void AutoSearchCrossValidationDriver::resetForOptimal(
 
 	ccd.setWeights(NULL);
 	ccd.setHyperprior(maxPoint);
-	ccd.resetBeta(); // Cold-start
+	if (!arguments.usePath) {
+		ccd.resetBeta(); // Cold-start
+	} // else warm-start from the last cross-validation fit, which is near maxPoint
 }
 
 void AutoSearchCrossValidationDriver::drive(
@@ -76,6 +78,7 @@ void AutoSearchCrossValidationDriver::drive(
 	// TODO Check that selector is type of CrossValidationSelector
 
 	std::vector<real> weights;
+	std::vector<real> trainingWeights;
 
 	double tryvalue = modelData.getNormalBasedDefaultVar();
 	UniModalSearch searcher(10, 0.01, log(1.5));
@@ -105,11 +108,18 @@ void AutoSearchCrossValidationDriver::drive(
 					}
 				}
 			}
-			ccd.setWeights(&weights[0]);
-			std::cout << "Running at " << ccd.getPriorInfo() << " ";
-			ccd.update(arguments.maxIterations, arguments.convergenceType, arguments.tolerance);
+			// Fit on the training rows only
+			CyclicCoordinateDescent* training = ccd.cloneOnRows(&weights[0]);
+			std::cout << "Running at " << training->getPriorInfo() << " ";
+			training->update(arguments.maxIterations, arguments.convergenceType, arguments.tolerance);
+			std::vector<double> beta(training->getBetaSize());
+			for (int j = 0; j < training->getBetaSize(); ++j) {
+				beta[j] = training->getBeta(j);
+			}
+			delete training;
 
 			// Compute predictive loglikelihood for this fold
+			trainingWeights = weights;
 			selector.getComplement(weights);
 			if(weightsExclude){
 				for(int j = 0; j < (int)weightsExclude->size(); j++){
@@ -119,6 +129,9 @@ void AutoSearchCrossValidationDriver::drive(
 				}
 			}
 
+			// Next fold warm-starts here, as before
+			ccd.setWeights(&trainingWeights[0]);
+			ccd.setBeta(beta);
 			double logLikelihood = ccd.getPredictiveLogLikelihood(&weights[0]);
 
 			std::cout << "Grid-point #" << (step + 1) << " at " << tryvalue;
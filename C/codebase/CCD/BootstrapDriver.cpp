@@ -12,8 +12,10 @@
 #include <cstdlib>
 #include <cmath>
 
+#include <thread>
+
 #include "BootstrapDriver.h"
-#include "AbstractSelector.h"
+#include "BootstrapSelector.h"
 
 namespace bsccs {
 
@@ -43,23 +45,114 @@ void BootstrapDriver::drive(
 		AbstractSelector& selector,
 		const CCDArguments& arguments) {
 
-	// TODO Make sure that selector is type-of BootstrapSelector
+	BootstrapSelector* bootstrapSelector = dynamic_cast<BootstrapSelector*>(&selector);
+	if (!bootstrapSelector) {
+		cerr << "Bootstrap driver requires a bootstrap selector." << endl;
+		exit(-1);
+	}
+
+	const int nThreads = std::max(1, std::min(arguments.threads, replicates));
+
+	// Each worker owns its engine and selector; only ModelData is shared
+	std::vector<CyclicCoordinateDescent*> engines(1, &ccd);
+	std::vector<BootstrapSelector*> selectors(1, bootstrapSelector);
+	for (int t = 1; t < nThreads; ++t) {
+		engines.push_back(ccd.clone());
+		selectors.push_back(new BootstrapSelector(*bootstrapSelector));
+	}
+	if (nThreads > 1) {
+		for (int t = 0; t < nThreads; ++t) {
+			engines[t]->setNoiseLevel(SILENT);
+			engines[t]->setThreads(1); // Threads are used across replicates instead
+		}
+	}
+
+	// Every replicate warm-starts from the point estimate
+	startBeta.resize(J);
+	for (int j = 0; j < J; ++j) {
+		startBeta[j] = ccd.getBeta(j);
+	}
+
+	keepRawEstimates = arguments.reportRawEstimates;
+	summaries.assign(J, BootstrapSummary());
+	nextReplicate = 0;
+	nextToStore = 0;
+	pending.clear();
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < nThreads; ++t) {
+		workers.push_back(std::thread(&BootstrapDriver::runReplicates, this,
+				engines[t], selectors[t], &arguments));
+	}
+	runReplicates(engines[0], selectors[0], &arguments);
+	for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+		it->join();
+	}
+
+	for (int t = 1; t < nThreads; ++t) {
+		delete engines[t];
+		delete selectors[t];
+	}
+
+	// Restore point estimate
+	ccd.setNoiseLevel(arguments.noiseLevel);
+	ccd.setThreads(arguments.threads);
+	ccd.setWeights(NULL);
+	ccd.setBeta(startBeta);
+}
+
+void BootstrapDriver::runReplicates(
+		CyclicCoordinateDescent* ccd,
+		BootstrapSelector* selector,
+		const CCDArguments* arguments) {
+
 	std::vector<real> weights;
+	rvector beta(J);
 
-	for (int step = 0; step < replicates; step++) {
-		selector.permute();
-		selector.getWeights(0, weights);
-		ccd.setWeights(&weights[0]);
+	while (true) {
+		int step;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			step = nextReplicate++;
+		}
+		if (step >= replicates) {
+			break;
+		}
 
-		std::cout << std::endl << "Running replicate #" << (step + 1) << std::endl;
-		// Run CCD using a warm start
-		ccd.update(arguments.maxIterations, arguments.convergenceType, arguments.tolerance);
+		// Replicate-specific stream, so draws do not depend on the number of threads
+		selector->setStream(step + 1);
+		selector->permute();
+		selector->getWeights(0, weights);
+
+		// Rows drawn zero times are left out of the fit entirely
+		CyclicCoordinateDescent* replicate = ccd->cloneOnRows(&weights[0]);
+		replicate->setBeta(startBeta);
+		replicate->update(arguments->maxIterations, arguments->convergenceType,
+				arguments->tolerance);
 
-		// Store point estimates
 		for (int j = 0; j < J; ++j) {
-			estimates[j]->push_back(ccd.getBeta(j));
+			beta[j] = replicate->getBeta(j);
 		}
-		exit(-1); // ***
+		delete replicate;
+		storeEstimates(step, beta);
+	}
+}
+
+void BootstrapDriver::storeEstimates(int replicate, const rvector& beta) {
+	std::lock_guard<std::mutex> guard(lock);
+	pending[replicate] = beta;
+
+	std::map<int, rvector>::iterator it;
+	while ((it = pending.find(nextToStore)) != pending.end()) {
+		std::cout << "Finished replicate #" << (nextToStore + 1) << std::endl;
+		for (int j = 0; j < J; ++j) {
+			summaries[j].add(it->second[j]);
+			if (keepRawEstimates) {
+				estimates[j]->push_back(it->second[j]);
+			}
+		}
+		pending.erase(it);
+		++nextToStore;
 	}
 }
 
@@ -92,28 +185,12 @@ void BootstrapDriver::logResults(const CCDArguments& arguments, std::vector<real
 			copy(estimates[j]->begin(), estimates[j]->end(), output);
 			outLog << endl;
 		} else {
-			real mean = 0.0;
-			real var = 0.0;
-			real prob0 = 0.0;
-			for (rvector::iterator it = estimates[j]->begin(); it != estimates[j]->end(); ++it) {
-				mean += *it;
-				var += *it * *it;
-				if (*it == 0.0) {
-					prob0 += 1.0;
-				}
-			}
-
-			real size = static_cast<real>(estimates[j]->size());
-			mean /= size;
-			var = (var / size) - (mean * mean);
-			prob0 /= size;
-
-			sort(estimates[j]->begin(), estimates[j]->end());
-			int offsetLower = static_cast<int>(size * 0.025);
-			int offsetUpper = static_cast<int>(size * 0.975);
-
-			real lower = *(estimates[j]->begin() + offsetLower);
-			real upper = *(estimates[j]->begin() + offsetUpper);
+			const BootstrapSummary& summary = summaries[j];
+			real mean = summary.getMean();
+			real var = summary.getVariance();
+			real prob0 = summary.getProbabilityZero();
+			real lower = summary.getLower();
+			real upper = summary.getUpper();
 
 			outLog << savedBeta[j] << sep;
 			outLog << std::sqrt(var) << sep << mean << sep << lower << sep << upper << sep << prob0 << endl;
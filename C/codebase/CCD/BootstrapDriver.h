@@ -9,12 +9,17 @@
 #define BOOTSTRAPDRIVER_H_
 
 #include <vector>
+#include <map>
+#include <mutex>
 
 #include "AbstractDriver.h"
 #include "ModelData.h"
+#include "BootstrapSummary.h"
 
 namespace bsccs {
 
+class BootstrapSelector; // forward declaration
+
 typedef std::vector<real> rvector;
 typedef std::vector<rvector*> rarray;
 typedef	rarray::iterator rarrayIterator;
@@ -37,10 +42,27 @@ public:
 	void logResults(const CCDArguments& arguments, std::vector<real>& savedBeta, std::string conditionId);
 
 private:
+
+	void runReplicates(
+			CyclicCoordinateDescent* ccd,
+			BootstrapSelector* selector,
+			const CCDArguments* arguments);
+
+	void storeEstimates(int replicate, const rvector& beta);
+
 	const int replicates;
 	ModelData* modelData;
 	const int J;
-	rarray estimates;
+	rarray estimates; // Only kept when raw estimates are reported
+	std::vector<BootstrapSummary> summaries;
+	std::vector<double> startBeta;
+	bool keepRawEstimates;
+
+	// Replicates are handed out in order and folded into the summaries in order
+	std::mutex lock;
+	int nextReplicate;
+	int nextToStore;
+	std::map<int, rvector> pending;
 };
 
 } // namespace
@@ -35,6 +35,7 @@ BootstrapSelector::BootstrapSelector(
 		}
 	}
 
+	setStream(0);
 	permute();
 
 //	exit(0);
@@ -44,16 +45,22 @@ BootstrapSelector::~BootstrapSelector() {
 	// Nothing to do
 }
 
+void BootstrapSelector::setStream(int stream) {
+	MTRand::uint32 key[2] = { static_cast<MTRand::uint32>(seed),
+			static_cast<MTRand::uint32>(stream) };
+	generator.seed(key, 2);
+}
+
 void BootstrapSelector::permute() {
-	selectedSet.clear();
+	selectedCount.assign(N, 0);
 
 	// Get non-excluded indices
 	int N_new = indicesIncluded.size();
 	if (type == SUBJECT) {
 		for (int i = 0; i < N_new; i++) {
-			int ind = rand() / (RAND_MAX / N_new + 1);
+			int ind = generator.randInt(N_new - 1);
 			int draw = indicesIncluded[ind];
-			selectedSet.insert(draw);
+			selectedCount[draw]++;
 		}
 	} else {
 		std::cerr << "BootstrapSelector::permute is not yet implemented." << std::endl;
@@ -82,8 +89,7 @@ void BootstrapSelector::getWeights(int batch, std::vector<real>& weights) {
 
 	if (type == SUBJECT) {
 		for (int k = 0; k < K; k++) {
-			int count = selectedSet.count(ids->at(k));
-			weights[k] = static_cast<real>(count);
+			weights[k] = static_cast<real>(selectedCount[ids->at(k)]);
 		}
 	} else {
 		std::cerr << "BootstrapSelector::getWeights is not yet implemented." << std::endl;
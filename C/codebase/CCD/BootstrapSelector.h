@@ -8,9 +8,8 @@
 #ifndef BOOTSTRAPSELECTOR_H_
 #define BOOTSTRAPSELECTOR_H_
 
-#include <set>
-
 #include "AbstractSelector.h"
+#include "MT/MersenneTwister.h"
 
 namespace bsccs {
 
@@ -31,8 +30,12 @@ public:
 
 	virtual void getComplement(std::vector<real>& weights);
 
+	// Restart the generator on an independent stream (e.g., one per replicate)
+	void setStream(int stream);
+
 private:
-	std::multiset<int> selectedSet;
+	MTRand generator;
+	std::vector<int> selectedCount;
 	std::vector<int> indicesIncluded;
 };
 
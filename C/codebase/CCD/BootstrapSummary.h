@@ -0,0 +1,178 @@
+/*
+ * BootstrapSummary.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef BOOTSTRAPSUMMARY_H_
+#define BOOTSTRAPSUMMARY_H_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace bsccs {
+
+/*
+ * Streaming quantile estimate using the P-square algorithm (Jain and Chlamtac, 1985).
+ * The first bufferSize draws are kept and the exact order statistic is reported; on the
+ * next draw, five markers are placed on the sorted buffer and adjusted for each new draw,
+ * so storage does not grow with the number of draws.
+ */
+class StreamingQuantile {
+public:
+	StreamingQuantile(double inP, int inBufferSize = 100) : p(inP), bufferSize(inBufferSize),
+		count(0) {
+		buffer.reserve(bufferSize);
+	}
+
+	void add(double x) {
+		++count;
+		if (count <= bufferSize) {
+			buffer.push_back(x);
+			return;
+		}
+		if (count == bufferSize + 1) {
+			initializeMarkers(); // Buffer stays exact until a draw beyond it arrives
+		}
+
+		// Find cell containing x, extending the extreme markers if necessary
+		int k;
+		if (x < height[0]) {
+			height[0] = x;
+			k = 0;
+		} else if (x >= height[4]) {
+			height[4] = x;
+			k = 3;
+		} else {
+			k = 0;
+			while (x >= height[k + 1]) {
+				++k;
+			}
+		}
+
+		for (int i = k + 1; i < 5; ++i) {
+			position[i] += 1.0;
+		}
+		for (int i = 0; i < 5; ++i) {
+			desired[i] += increment[i];
+		}
+
+		// Adjust interior markers
+		for (int i = 1; i <= 3; ++i) {
+			const double d = desired[i] - position[i];
+			if ((d >= 1.0 && position[i + 1] - position[i] > 1.0) ||
+					(d <= -1.0 && position[i - 1] - position[i] < -1.0)) {
+				const int s = (d >= 0.0) ? 1 : -1;
+				const double candidate = parabolic(i, s);
+				if (height[i - 1] < candidate && candidate < height[i + 1]) {
+					height[i] = candidate;
+				} else {
+					height[i] = linear(i, s);
+				}
+				position[i] += s;
+			}
+		}
+	}
+
+	double getQuantile() const {
+		if (count > bufferSize) {
+			return height[2];
+		}
+		if (count == 0) {
+			return NAN;
+		}
+		std::vector<double> sorted(buffer);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[static_cast<int>(count * p)];
+	}
+
+private:
+
+	void initializeMarkers() {
+		std::sort(buffer.begin(), buffer.end());
+		const double last = static_cast<double>(bufferSize - 1);
+		desired[0] = 0.0;
+		desired[1] = last * p / 2.0;
+		desired[2] = last * p;
+		desired[3] = last * (1.0 + p) / 2.0;
+		desired[4] = last;
+		for (int i = 0; i < 5; ++i) {
+			position[i] = std::floor(desired[i] + 0.5);
+			if (i > 0 && position[i] <= position[i - 1]) {
+				position[i] = position[i - 1] + 1.0;
+			}
+			height[i] = buffer[static_cast<int>(position[i])];
+			increment[i] = desired[i] / last;
+		}
+		std::vector<double>().swap(buffer); // Release storage
+	}
+
+	double parabolic(int i, int d) const {
+		return height[i] + d / (position[i + 1] - position[i - 1]) * (
+				(position[i] - position[i - 1] + d) * (height[i + 1] - height[i]) /
+					(position[i + 1] - position[i]) +
+				(position[i + 1] - position[i] - d) * (height[i] - height[i - 1]) /
+					(position[i] - position[i - 1]));
+	}
+
+	double linear(int i, int d) const {
+		return height[i] + d * (height[i + d] - height[i]) / (position[i + d] - position[i]);
+	}
+
+	double p;
+	int bufferSize;
+	int count;
+	std::vector<double> buffer;
+
+	double height[5];
+	double position[5];
+	double desired[5];
+	double increment[5];
+};
+
+/*
+ * Running mean, variance, probability of zero and 95% interval for one covariate.
+ */
+class BootstrapSummary {
+public:
+	BootstrapSummary() : count(0), mean(0.0), sumSquares(0.0), zeros(0),
+		lower(0.025), upper(0.975) {
+		// Do nothing
+	}
+
+	void add(double x) {
+		++count;
+		const double delta = x - mean;
+		mean += delta / count;
+		sumSquares += delta * (x - mean);
+		if (x == 0.0) {
+			++zeros;
+		}
+		lower.add(x);
+		upper.add(x);
+	}
+
+	double getMean() const { return mean; }
+
+	double getVariance() const { return sumSquares / count; }
+
+	double getProbabilityZero() const { return static_cast<double>(zeros) / count; }
+
+	double getLower() const { return lower.getQuantile(); }
+
+	double getUpper() const { return upper.getQuantile(); }
+
+private:
+	int count;
+	double mean;
+	double sumSquares;
+	int zeros;
+	StreamingQuantile lower;
+	StreamingQuantile upper;
+};
+
+} // namespace
+
+#endif /* BOOTSTRAPSUMMARY_H_ */
@@ -10,12 +10,15 @@
 #include <algorithm>
 #include <numeric>
 #include <vector>
+#include <thread>
 
 #include "CompressedDataMatrix.h"
+#include "Iterators.h"
 
 namespace bsccs {
 
-CompressedDataMatrix::CompressedDataMatrix() : nCols(0), nRows(0), nEntries(0) {
+CompressedDataMatrix::CompressedDataMatrix() : nCols(0), nRows(0), nEntries(0),
+		rowMajorBudget(defaultRowMajorBudget), bitmapDensity(defaultBitmapDensity), packIndices(false) {
 	// Do nothing
 }
 
@@ -34,6 +37,10 @@ real CompressedDataMatrix::sumColumn(int column) {
 	} else if (getFormatType(column) == SPARSE) {
 		cerr << "Not yet implemented (SPARSE)." << endl;
 		exit(-1);
+	} else if (getFormatType(column) == BITMAP) {
+		sum = allColumns[column]->countBitmapRows();
+	} else if (getFormatType(column) == PACKED) {
+		sum = allColumns[column]->countPackedRows();
 	} else { // is indiciator
 		sum = allColumns[column]->getNumberOfEntries();
 	}
@@ -86,12 +93,276 @@ void CompressedDataMatrix::printColumn(int column) {
 #endif
 }
 
+void CompressedDataMatrix::finalize() {
+	if (bitmapDensity > 0.0) {
+		for (int j = 0; j < nCols; ++j) {
+			CompressedDataColumn& column = *allColumns[j];
+			if (column.getFormatType() == INDICATOR && nRows > 0 &&
+					column.getNumberOfEntries() >= bitmapDensity * nRows) {
+				column.convertColumnToBitmap(nRows);
+			}
+		}
+	}
+	if (packIndices) {
+		for (int j = 0; j < nCols; ++j) {
+			CompressedDataColumn& column = *allColumns[j];
+			if (column.getFormatType() == INDICATOR &&
+					column.getNumberOfEntries() >= packedBlockSize) {
+				column.convertColumnToPacked();
+			}
+		}
+	}
+
+	std::vector<size_t> newIndexPointers(1, 0);
+	std::vector<size_t> newDataPointers(1, 0);
+	newIndexPointers.reserve(nCols + 1);
+	newDataPointers.reserve(nCols + 1);
+	for (int j = 0; j < nCols; ++j) {
+		const CompressedDataColumn& column = *allColumns[j];
+		newIndexPointers.push_back(newIndexPointers.back() +
+				(column.hasColumns() ? column.getNumberOfWords() : 0));
+		newDataPointers.push_back(newDataPointers.back() +
+				(column.hasData() ? column.getDataVectorLength() : 0));
+	}
+
+	int_vector newIndexArena(newIndexPointers.back());
+	real_vector newDataArena(newDataPointers.back());
+
+	// Move one column at a time, so peak memory stays near one copy of the data
+	for (int j = 0; j < nCols; ++j) {
+		CompressedDataColumn& column = *allColumns[j];
+		int* cols = NULL;
+		real* values = NULL;
+		const int nIndices = newIndexPointers[j + 1] - newIndexPointers[j];
+		const int nValues = newDataPointers[j + 1] - newDataPointers[j];
+		if (column.hasColumns()) {
+			cols = newIndexArena.data() + newIndexPointers[j];
+			std::copy(column.getColumns(), column.getColumns() + nIndices, cols);
+		}
+		if (column.hasData()) {
+			values = newDataArena.data() + newDataPointers[j];
+			std::copy(column.getData(), column.getData() + nValues, values);
+		}
+		column.attachToArena(cols, nIndices, values, nValues);
+	}
+
+	// Any previous arena is released here
+	indexPointers.swap(newIndexPointers);
+	dataPointers.swap(newDataPointers);
+	indexArena.swap(newIndexArena);
+	dataArena.swap(newDataArena);
+	mappedArena.reset();
+	releaseRows();
+}
+
 void CompressedDataMatrix::convertColumnToSparse(int column) {
 	allColumns[column]->convertColumnToSparse();
+	releaseRows();
 }
 
 void CompressedDataMatrix::convertColumnToDense(int column) {
 	allColumns[column]->convertColumnToDense(nRows);
+	releaseRows();
+}
+
+void CompressedDataMatrix::convertColumnToBitmap(int column) {
+	allColumns[column]->convertColumnToBitmap(nRows);
+	releaseRows();
+}
+
+void CompressedDataMatrix::convertColumnToPacked(int column) {
+	allColumns[column]->convertColumnToPacked();
+	releaseRows();
+}
+
+void CompressedDataMatrix::setPackedIndices(bool pack) {
+	packIndices = pack;
+}
+
+void CompressedDataMatrix::convertColumnToIndicator(int column) {
+	allColumns[column]->convertColumnToIndicator();
+	releaseRows();
+}
+
+void CompressedDataMatrix::setBitmapDensity(double density) {
+	bitmapDensity = density;
+}
+
+int CompressedDataMatrix::getColumnSize(int column) const {
+	const FormatType format = allColumns[column]->getFormatType();
+	if (format == BITMAP) {
+		return allColumns[column]->countBitmapRows();
+	} else if (format == PACKED) {
+		return allColumns[column]->countPackedRows();
+	}
+	return (format == SPARSE || format == INDICATOR) ?
+			allColumns[column]->getNumberOfEntries() : nRows;
+}
+
+namespace {
+
+/*
+ * Visits the entries of rows [begin, end) column by column; rows of a column arrive in
+ * increasing order, so each row sees its entries in increasing column order
+ */
+template <class Visitor>
+void visitRows(const CompressedDataMatrix& matrix, int begin, int end, Visitor& visitor) {
+	for (int j = 0; j < matrix.getNumberOfColumns(); ++j) {
+		const FormatType format = matrix.getFormatType(j);
+		if (format == SPARSE || format == INDICATOR) {
+			const int* rows = matrix.getCompressedColumnVector(j);
+			const real* data = matrix.getDataVector(j);
+			const int n = matrix.getNumberOfEntries(j);
+			for (int i = std::lower_bound(rows, rows + n, begin) - rows;
+					i < n && rows[i] < end; ++i) {
+				visitor(rows[i], j, (format == SPARSE) ? data[i] : static_cast<real>(1));
+			}
+		} else if (format == BITMAP) {
+			const int* words = matrix.getCompressedColumnVector(j);
+			const int last = std::min(matrix.getNumberOfWords(j), getBitmapLength(end));
+			for (int w = begin / bitmapWordBits; w < last; ++w) {
+				for (unsigned int bits = words[w]; bits; bits &= bits - 1) {
+					const int k = w * bitmapWordBits + lowestBit(bits);
+					if (k >= begin && k < end) {
+						visitor(k, j, static_cast<real>(1));
+					}
+				}
+			}
+		} else if (format == PACKED) {
+			for (PackedIterator it(matrix, j); it && it.index() < end; ++it) {
+				if (it.index() >= begin) {
+					visitor(it.index(), j, static_cast<real>(1));
+				}
+			}
+		} else if (format == DENSE) {
+			const real* data = matrix.getDataVector(j);
+			for (int k = begin; k < end; ++k) {
+				visitor(k, j, data[k]);
+			}
+		} else { // INTERCEPT
+			for (int k = begin; k < end; ++k) {
+				visitor(k, j, static_cast<real>(1));
+			}
+		}
+	}
+}
+
+struct RowCounter {
+	std::vector<size_t>& counts; // Entries of row k in counts[k + 1]
+	void operator()(int k, int j, real value) {
+		++counts[k + 1];
+	}
+};
+
+struct RowFiller {
+	CompressedDataRows& rows;
+	std::vector<size_t> next; // Next free position of rows begin, begin + 1, ...
+	int begin;
+	void operator()(int k, int j, real value) {
+		const size_t position = next[k - begin]++;
+		rows.columns[position] = j;
+		rows.values[position] = value;
+	}
+};
+
+void countRows(const CompressedDataMatrix* matrix, std::vector<size_t>* counts,
+		int begin, int end) {
+	RowCounter counter = { *counts };
+	visitRows(*matrix, begin, end, counter);
+}
+
+void fillRows(const CompressedDataMatrix* matrix, CompressedDataRows* rows, int begin, int end) {
+	RowFiller filler = { *rows,
+			std::vector<size_t>(rows->rowPointers.begin() + begin, rows->rowPointers.begin() + end),
+			begin };
+	visitRows(*matrix, begin, end, filler);
+}
+
+void multiplyRows(const CompressedDataRows* rows, const double* beta, real* out,
+		int begin, int end) {
+	for (int k = begin; k < end; ++k) {
+		real sum = static_cast<real>(0);
+		for (size_t i = rows->rowPointers[k]; i < rows->rowPointers[k + 1]; ++i) {
+			const real b = static_cast<real>(beta[rows->columns[i]]);
+			if (b != static_cast<real>(0)) { // As axpy, skip zero coefficients
+				sum += b * rows->values[i];
+			}
+		}
+		out[k] = sum;
+	}
+}
+
+// Runs task(begin, end) over threads contiguous blocks of [0, n); threads = 1 runs in place
+template <typename Task, typename... Args>
+void forRowBlocks(int n, int threads, Task task, Args... args) {
+	if (threads <= 1) {
+		task(args..., 0, n);
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		const int begin = static_cast<int>(static_cast<long>(n) * t / threads);
+		const int end = static_cast<int>(static_cast<long>(n) * (t + 1) / threads);
+		workers.push_back(std::thread(task, args..., begin, end));
+	}
+	for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+		it->join();
+	}
+}
+
+const int minRowsPerThread = 4096;
+
+int rowThreads(int nRows, int threads) {
+	return std::max(1, std::min(threads, nRows / minRowsPerThread));
+}
+
+} // namespace
+
+void CompressedDataRows::multiply(const double* beta, real* out, int threads) const {
+	const int nRows = rowPointers.size() - 1;
+	forRowBlocks(nRows, rowThreads(nRows, threads), multiplyRows, this, beta, out);
+}
+
+std::shared_ptr<const CompressedDataRows> CompressedDataMatrix::getRows(int threads) const {
+	std::lock_guard<std::mutex> lock(rowsMutex);
+	if (rows) {
+		return rows;
+	}
+
+	size_t entries = 0;
+	for (int j = 0; j < nCols; ++j) {
+		entries += getColumnSize(j);
+	}
+	const size_t bytes = entries * (sizeof(int) + sizeof(real)) + (nRows + 1) * sizeof(size_t);
+	if (bytes > rowMajorBudget) {
+		return rows; // NULL
+	}
+
+	std::shared_ptr<CompressedDataRows> mirror = std::make_shared<CompressedDataRows>();
+	mirror->rowPointers.assign(nRows + 1, 0);
+	mirror->columns.resize(entries);
+	mirror->values.resize(entries);
+
+	// Count entries per row, prefix-sum to offsets, then fill; threads own disjoint rows
+	const int workers = rowThreads(nRows, threads);
+	forRowBlocks(nRows, workers, countRows, this, &mirror->rowPointers);
+	for (int k = 0; k < nRows; ++k) {
+		mirror->rowPointers[k + 1] += mirror->rowPointers[k];
+	}
+	forRowBlocks(nRows, workers, fillRows, this, mirror.get());
+
+	rows = mirror;
+	return rows;
+}
+
+void CompressedDataMatrix::releaseRows() const {
+	std::lock_guard<std::mutex> lock(rowsMutex);
+	rows.reset();
+}
+
+void CompressedDataMatrix::setRowMajorBudget(size_t bytes) {
+	rowMajorBudget = bytes;
+	releaseRows();
 }
 
 int CompressedDataMatrix::getNumberOfRows(void) const {
@@ -106,6 +377,10 @@ int CompressedDataMatrix::getNumberOfEntries(int column) const {
 	return allColumns[column]->getNumberOfEntries();
 }
 
+int CompressedDataMatrix::getNumberOfWords(int column) const {
+	return allColumns[column]->getNumberOfWords();
+}
+
 int* CompressedDataMatrix::getCompressedColumnVector(int column) const {
 	return allColumns[column]->getColumns();
 }
@@ -118,10 +393,64 @@ FormatType CompressedDataMatrix::getFormatType(int column) const {
 	return allColumns[column]->getFormatType();
 }
 
+std::vector<int> CompressedDataMatrix::getColumnsByFormat(FormatType format) const {
+	std::vector<int> columns;
+	for (int j = 0; j < nCols; j++) {
+		if (allColumns[j]->getFormatType() == format) {
+			columns.push_back(j);
+		}
+	}
+	return columns;
+}
+
+void CompressedDataColumn::attachToArena(int* cols, int nEntries, real* values, int nValues) {
+	if (columns) {
+		delete columns; columns = NULL;
+	}
+	if (data) {
+		delete data; data = NULL;
+	}
+	arenaColumns = cols;
+	arenaEntries = nEntries;
+	arenaData = values;
+	arenaDataLength = nValues;
+	inArena = true;
+}
+
+void CompressedDataColumn::detachFromArena() {
+	if (!inArena) {
+		return;
+	}
+	if (arenaColumns) {
+		columns = new int_vector(arenaColumns, arenaColumns + arenaEntries);
+	}
+	if (arenaData) {
+		data = new real_vector(arenaData, arenaData + arenaDataLength);
+	}
+	arenaColumns = NULL;
+	arenaData = NULL;
+	arenaEntries = 0;
+	arenaDataLength = 0;
+	inArena = false;
+}
+
 void CompressedDataColumn::fill(real_vector& values, int nRows) {
 	values.resize(nRows);
 	if (formatType == DENSE) {
-			values.assign(data->begin(), data->end());
+			values.assign(getData(), getData() + getDataVectorLength());
+		} else if (formatType == BITMAP) {
+			values.assign(nRows, 0.0);
+			const int* words = getColumns();
+			for (int w = 0; w < getNumberOfWords(); ++w) {
+				for (unsigned int bits = words[w]; bits; bits &= bits - 1) {
+					values[w * bitmapWordBits + lowestBit(bits)] = 1.0;
+				}
+			}
+		} else if (formatType == PACKED) {
+			values.assign(nRows, 0.0);
+			for (PackedIterator it(*this); it; ++it) {
+				values[it.index()] = 1.0;
+			}
 		} else {
 			bool isSparse = formatType == SPARSE;
 			values.assign(nRows, 0.0);
@@ -130,7 +459,7 @@ void CompressedDataColumn::fill(real_vector& values, int nRows) {
 			for (int i = 0; i < n; ++i) {
 				const int k = indicators[i];
 				if (isSparse) {
-					values[k] = data->at(i);
+					values[k] = getData()[i];
 				} else {
 					values[k] = 1.0;
 				}
@@ -151,7 +480,7 @@ CompressedDataMatrix* CompressedDataMatrix::transpose() {
 		FormatType thisFormatType = this->allColumns[i]->getFormatType();
 		if (thisFormatType == DENSE)
 			flagDense = true;
-		if (thisFormatType == INDICATOR)
+		if (thisFormatType == INDICATOR || thisFormatType == BITMAP || thisFormatType == PACKED)
 			flagIndicator = true;
 	}
 
@@ -171,7 +500,19 @@ CompressedDataMatrix* CompressedDataMatrix::transpose() {
 
 	for (int i = 0; i < matTranspose->nRows; i++) {
 		FormatType thisFormatType = this->allColumns[i]->getFormatType();
-		if (thisFormatType == INDICATOR || thisFormatType == SPARSE) {
+		if (thisFormatType == BITMAP) {
+			const int* words = this->getCompressedColumnVector(i);
+			for (int w = 0; w < this->getNumberOfWords(i); w++) {
+				for (unsigned int bits = words[w]; bits; bits &= bits - 1) {
+					matTranspose->allColumns[w * bitmapWordBits + lowestBit(bits)]->add_data(
+							i, 1.0);
+				}
+			}
+		} else if (thisFormatType == PACKED) {
+			for (PackedIterator it(*this, i); it; ++it) {
+				matTranspose->allColumns[it.index()]->add_data(i, 1.0);
+			}
+		} else if (thisFormatType == INDICATOR || thisFormatType == SPARSE) {
 			int rows = this->getNumberOfEntries(i);
 			for (int j = 0; j < rows; j++) {
 				if (thisFormatType == SPARSE)
@@ -207,6 +548,20 @@ void CompressedDataMatrix::getDataRow(int row, real* x) const {
 	{
 		if(this->allColumns[j]->getFormatType() == DENSE)
 			x[j] = this->getDataVector(j)[row];
+		else if(this->allColumns[j]->getFormatType() == BITMAP){
+			const int w = row / bitmapWordBits;
+			x[j] = (w < this->getNumberOfWords(j) &&
+					(static_cast<unsigned int>(this->getCompressedColumnVector(j)[w]) >>
+							(row % bitmapWordBits)) & 1u) ? 1.0 : 0.0;
+		}
+		else if(this->allColumns[j]->getFormatType() == PACKED){
+			x[j] = 0.0;
+			for (PackedIterator it(*this, j); it && it.index() <= row; ++it) {
+				if (it.index() == row) {
+					x[j] = 1.0;
+				}
+			}
+		}
 		else{
 			x[j] = 0.0;
 			int* col = this->getCompressedColumnVector(j);
@@ -242,19 +597,140 @@ real CompressedDataColumn::sumColumn(int nRows) {
 real CompressedDataColumn::squaredSumColumn() const {
 	if (formatType == INDICATOR) {
 		return getNumberOfEntries();
+	} else if (formatType == BITMAP) {
+		return countBitmapRows();
+	} else if (formatType == PACKED) {
+		return countPackedRows();
 	} else {
-		return std::inner_product( data->begin(), data->end(), data->begin(), static_cast<real>(0.0));
+		return std::inner_product(getData(), getData() + getDataVectorLength(), getData(), static_cast<real>(0.0));
 	}
 }
 
+int CompressedDataColumn::countBitmapRows() const {
+	const int* words = getColumns();
+	int count = 0;
+	for (int w = 0; w < getNumberOfWords(); ++w) {
+		count += countBits(words[w]);
+	}
+	return count;
+}
+
+void CompressedDataColumn::convertColumnToBitmap(int nRows) {
+	if (formatType == BITMAP) {
+		return;
+	}
+	if (formatType != INDICATOR) {
+		fprintf(stderr, "Format not yet support.\n");
+		exit(-1);
+	}
+	int_vector* words = new int_vector(getBitmapLength(nRows), 0);
+	const int* indicators = getColumns();
+	const int n = getNumberOfEntries();
+	for (int i = 0; i < n; ++i) {
+		const int k = indicators[i];
+		(*words)[k / bitmapWordBits] |= static_cast<int>(1u << (k % bitmapWordBits));
+	}
+	detachFromArena();
+	delete columns;
+	columns = words;
+	formatType = BITMAP;
+}
+
+void CompressedDataColumn::convertColumnToPacked(void) {
+	if (formatType == PACKED) {
+		return;
+	}
+	if (formatType != INDICATOR) {
+		fprintf(stderr, "Format not yet support.\n");
+		exit(-1);
+	}
+	const int* rows = getColumns();
+	const int n = getNumberOfEntries();
+	int_vector* packed = new int_vector(1, n);
+	for (int first = 0; first < n; first += packedBlockSize) {
+		const int count = std::min(packedBlockSize, n - first);
+		const int base = (first == 0) ? -1 : rows[first - 1];
+
+		unsigned int bits = 0;
+		for (int i = first, last = base; i < first + count; last = rows[i++]) {
+			if (rows[i] <= last) { // Not increasing
+				delete packed;
+				return;
+			}
+			bits |= static_cast<unsigned int>(rows[i] - last - 1);
+		}
+		int width = 0;
+		while (width < bitmapWordBits && (bits >> width) != 0) {
+			++width;
+		}
+
+		packed->push_back(base);
+		packed->push_back(width);
+		const size_t words = packed->size();
+		packed->resize(words + getPackedLength(count, width), 0);
+		for (int i = 0; i < count && width > 0; ++i) {
+			const unsigned int delta = static_cast<unsigned int>(
+					rows[first + i] - ((i == 0) ? base : rows[first + i - 1]) - 1);
+			const int bit = i * width;
+			const int shift = bit % bitmapWordBits;
+			int* word = packed->data() + words + bit / bitmapWordBits;
+			word[0] |= static_cast<int>(delta << shift);
+			if (shift + width > bitmapWordBits) {
+				word[1] |= static_cast<int>(delta >> (bitmapWordBits - shift));
+			}
+		}
+		if (static_cast<int>(packed->size()) >= n) { // Would not save space
+			delete packed;
+			return;
+		}
+	}
+	detachFromArena();
+	delete columns;
+	columns = packed;
+	formatType = PACKED;
+}
+
+void CompressedDataColumn::convertColumnToIndicator(void) {
+	if (formatType == INDICATOR) {
+		return;
+	}
+	int_vector* indicators = new int_vector();
+	if (formatType == BITMAP) {
+		indicators->reserve(countBitmapRows());
+		const int* words = getColumns();
+		for (int w = 0; w < getNumberOfWords(); ++w) {
+			for (unsigned int bits = words[w]; bits; bits &= bits - 1) {
+				indicators->push_back(w * bitmapWordBits + lowestBit(bits));
+			}
+		}
+	} else if (formatType == PACKED) {
+		indicators->reserve(countPackedRows());
+		for (PackedIterator it(*this); it; ++it) {
+			indicators->push_back(it.index());
+		}
+	} else {
+		delete indicators;
+		fprintf(stderr, "Format not yet support.\n");
+		exit(-1);
+	}
+	detachFromArena();
+	delete columns;
+	columns = indicators;
+	formatType = INDICATOR;
+}
+
 void CompressedDataColumn::convertColumnToSparse(void) {
 	if (formatType == SPARSE) {
 		return;
 	}
+	if (formatType == BITMAP || formatType == PACKED) {
+		convertColumnToIndicator();
+	}
 	if (formatType == DENSE) {
 		fprintf(stderr, "Format not yet support.\n");
 		exit(-1);
 	}
+	detachFromArena();
 
 	if (data == NULL) {
 		data = new real_vector();
@@ -269,6 +745,10 @@ void CompressedDataColumn::convertColumnToDense(int nRows) {
 	if (formatType == DENSE) {
 		return;
 	}
+	if (formatType == BITMAP || formatType == PACKED) {
+		convertColumnToIndicator();
+	}
+	detachFromArena();
 //	if (formatType == SPARSE) {
 //		fprintf(stderr, "Format not yet support.\n");
 //		exit(-1);
@@ -303,6 +783,10 @@ void CompressedDataColumn::convertColumnToDense(int nRows) {
 
 // TODO Fix massive copying
 void CompressedDataColumn::addToColumnVector(int_vector addEntries){
+	if (formatType == BITMAP || formatType == PACKED) {
+		convertColumnToIndicator();
+	}
+	detachFromArena();
 	int lastit = 0;
 
 	for(int i = 0; i < (int)addEntries.size(); i++)
@@ -319,6 +803,10 @@ void CompressedDataColumn::addToColumnVector(int_vector addEntries){
 }
 
 void CompressedDataColumn::removeFromColumnVector(int_vector removeEntries){
+	if (formatType == BITMAP || formatType == PACKED) {
+		convertColumnToIndicator();
+	}
+	detachFromArena();
 	int lastit = 0;
 	int_vector::iterator it1 = removeEntries.begin();
 	int_vector::iterator it2 = columns->begin();
@@ -17,6 +17,8 @@
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <mutex>
 
 using std::cout;
 using std::cerr;
@@ -37,16 +39,94 @@ typedef std::vector<int> int_vector;
 typedef std::vector<real> real_vector;
 
 enum FormatType {
-	DENSE, SPARSE, INDICATOR, INTERCEPT
+	DENSE, SPARSE, INDICATOR, INTERCEPT, BITMAP, PACKED
 };
 
+/*
+ * A BITMAP column is an indicator column stored as one bit per row, packed into 32-bit
+ * words that are kept in the column's index vector.  Row k is bit (k % 32) of word k / 32.
+ */
+const int bitmapWordBits = 32;
+
+inline int getBitmapLength(int nRows) {
+	return (nRows + bitmapWordBits - 1) / bitmapWordBits;
+}
+
+inline int countBits(unsigned int word) {
+#ifdef __GNUC__
+	return __builtin_popcount(word);
+#else
+	int count = 0;
+	for (; word; word &= word - 1) {
+		++count;
+	}
+	return count;
+#endif
+}
+
+// Position of the lowest set bit; word must be non-zero
+inline int lowestBit(unsigned int word) {
+#ifdef __GNUC__
+	return __builtin_ctz(word);
+#else
+	int bit = 0;
+	for (; !(word & 1u); word >>= 1) {
+		++bit;
+	}
+	return bit;
+#endif
+}
+
+/*
+ * A PACKED column is an indicator column whose increasing rows are delta-encoded in blocks
+ * of packedBlockSize, kept in the column's index vector as
+ * 	[number of rows] then per block [base][width][deltas]
+ * where base is the row before the block (-1 for the first), and each row minus its
+ * predecessor minus 1 is stored in width bits, packed into 32-bit words.
+ */
+const int packedBlockSize = 128;
+
+// Words holding n deltas of width bits
+inline int getPackedLength(int n, int width) {
+	return (n * width + bitmapWordBits - 1) / bitmapWordBits;
+}
+
+// Decodes into rows the n rows of the PACKED block that starts at block, i.e. at its base
+inline void unpackBlock(const int* block, int n, int* rows) {
+	const int base = block[0];
+	const int width = block[1];
+	const int* words = block + 2;
+	if (width == 0) { // Consecutive rows
+		for (int i = 0; i < n; ++i) {
+			rows[i] = base + 1 + i;
+		}
+		return;
+	}
+	const unsigned int mask = (width == bitmapWordBits) ? ~0u : (1u << width) - 1u;
+	for (int i = 0; i < n; ++i) { // Independent iterations, so this loop can vectorize
+		const int bit = i * width;
+		const int w = bit / bitmapWordBits;
+		const int shift = bit % bitmapWordBits;
+		unsigned int delta = static_cast<unsigned int>(words[w]) >> shift;
+		if (shift + width > bitmapWordBits) {
+			delta |= static_cast<unsigned int>(words[w + 1]) << (bitmapWordBits - shift);
+		}
+		rows[i] = static_cast<int>(delta & mask) + 1;
+	}
+	rows[0] += base;
+	for (int i = 1; i < n; ++i) {
+		rows[i] += rows[i - 1];
+	}
+}
+
 typedef int DrugIdType;
 
 class CompressedDataColumn {
 public:
 	CompressedDataColumn(int_vector* colIndices, real_vector* colData, FormatType colFormat,
 			std::string colName = "", DrugIdType nName = 0) :
-		 columns(colIndices), data(colData), formatType(colFormat), stringName(colName), numericalName(nName) {
+		 columns(colIndices), data(colData), formatType(colFormat), stringName(colName), numericalName(nName),
+		 arenaColumns(NULL), arenaData(NULL), arenaEntries(0), arenaDataLength(0), inArena(false) {
 		// Do nothing
 	}
 	
@@ -60,11 +140,11 @@ public:
 	}
 
 	int* getColumns() const {
-		return static_cast<int*>(columns->data());
+		return inArena ? arenaColumns : static_cast<int*>(columns->data());
 	}
 	
 	real* getData() const {
-		return static_cast<real*>(data->data());
+		return inArena ? arenaData : static_cast<real*>(data->data());
 	}
 	
 	FormatType getFormatType() const {
@@ -84,13 +164,38 @@ public:
 		return numericalName;
 	}
 	
+	// Rows stored; the index vector of a BITMAP or PACKED column holds encoded words instead
 	int getNumberOfEntries() const {
-		return columns->size();
+		if (formatType == BITMAP) {
+			return countBitmapRows();
+		} else if (formatType == PACKED) {
+			return countPackedRows();
+		}
+		return getNumberOfWords();
+	}
+
+	// Length of the index vector
+	int getNumberOfWords() const {
+		return inArena ? arenaEntries : columns->size();
 	}
 
 	int getDataVectorLength() const {
-		return data->size();
+		return inArena ? arenaDataLength : data->size();
+	}
+
+	bool hasColumns() const {
+		return inArena ? arenaColumns != NULL : columns != NULL;
 	}
+
+	bool hasData() const {
+		return inArena ? arenaData != NULL : data != NULL;
+	}
+
+	// Releases owned storage and views entries held in a CompressedDataMatrix arena
+	void attachToArena(int* cols, int nEntries, real* values, int nValues);
+
+	// Copies arena entries back into owned storage before any modification
+	void detachFromArena();
 	
 	void add_label(std::string label) {
 		stringName = label;
@@ -101,6 +206,9 @@ public:
 	}	
 
 	bool add_data(int row, real value) {
+		if (inArena) {
+			detachFromArena();
+		}
 		if (formatType == DENSE) {
 			//Making sure that we are at the correct row
 			for(size_t i = data->size(); i < row; i++) {
@@ -133,10 +241,30 @@ public:
 		return true;
 	}
 
+	// Number of rows set in a BITMAP column
+	int countBitmapRows() const;
+
+	// Number of rows of a PACKED column
+	int countPackedRows() const {
+		return getColumns()[0];
+	}
+
 	void convertColumnToDense(int nRows);
 	
 	void convertColumnToSparse(void);
 
+	// Packs an INDICATOR column into a BITMAP column over nRows rows
+	void convertColumnToBitmap(int nRows);
+
+	/**
+	 * Delta-encodes an INDICATOR column into a PACKED column; keeps the column as it is when
+	 * its rows are not increasing or packing would not save space
+	 */
+	void convertColumnToPacked(void);
+
+	// Unpacks a BITMAP or PACKED column into an INDICATOR column
+	void convertColumnToIndicator(void);
+
 	void fill(real_vector& values, int nRows);
 
 	void printColumn(int nRows);
@@ -171,6 +299,28 @@ private:
 	FormatType formatType;
 	std::string stringName;
 	DrugIdType numericalName;
+
+	int* arenaColumns;
+	real* arenaData;
+	int arenaEntries;
+	int arenaDataLength;
+	bool inArena;
+};
+
+/**
+ * Row-major (CSR) copy of all stored entries of a CompressedDataMatrix, for products that run
+ * over rows.  Within a row, entries are in increasing column order.
+ */
+struct CompressedDataRows {
+	std::vector<size_t> rowPointers; // nRows + 1 offsets into columns and values
+	int_vector columns;
+	real_vector values;
+
+	/**
+	 * out[k] = sum_j x[k,j] * beta[j], with rows split across threads.  Each row adds its
+	 * terms in column order, as axpy over the columns does, so both give identical results.
+	 */
+	void multiply(const double* beta, real* out, int threads) const;
 };
 
 class CompressedDataMatrix {
@@ -191,6 +341,8 @@ public:
 
 	int getNumberOfEntries(int column) const;
 
+	int getNumberOfWords(int column) const;
+
 	int* getCompressedColumnVector(int column) const;
 
 	void removeFromColumnVector(int column, int_vector removeEntries) const;
@@ -199,18 +351,71 @@ public:
 	real* getDataVector(int column) const;
 
 	void getDataRow(int row, real* x) const;
+
+	// Number of rows for which column stores an entry
+	int getColumnSize(int column) const;
+
+	/**
+	 * Row-major mirror of the matrix, built on first request with threads workers and shared
+	 * until the matrix changes or the mirror is released.  NULL when it would not fit in the
+	 * row-major budget.  Thread-safe.
+	 */
+	std::shared_ptr<const CompressedDataRows> getRows(int threads) const;
+
+	void releaseRows() const;
+
+	// Memory budget for the row-major mirror, in bytes; 0 disables it
+	void setRowMajorBudget(size_t bytes);
+
+	const static size_t defaultRowMajorBudget = static_cast<size_t>(1) << 30;
 	CompressedDataMatrix* transpose();
 
 	FormatType getFormatType(int column) const;
 
+	/**
+	 * Indices of all columns stored in format, in increasing order.  Built on each call
+	 * since columns may change format after finalize().
+	 */
+	std::vector<int> getColumnsByFormat(FormatType format) const;
+
 	void convertColumnToDense(int column);
 
 	void convertColumnToSparse(int column);
 
+	void convertColumnToBitmap(int column);
+
+	void convertColumnToPacked(int column);
+
+	void convertColumnToIndicator(int column);
+
+	/**
+	 * Minimum fraction of rows an INDICATOR column must cover to be stored as BITMAP by
+	 * finalize(); 0 disables bitmaps
+	 */
+	void setBitmapDensity(double density);
+
+	// From 1 / 32 of rows on, a bitmap is no larger than the index list it replaces
+	constexpr static double defaultBitmapDensity = 0.03125;
+
+	/**
+	 * Whether finalize() delta-encodes INDICATOR columns of at least packedBlockSize rows
+	 * that stay INDICATOR; trades decoding work for fewer bytes per entry.  Off by default
+	 */
+	void setPackedIndices(bool pack);
+
 	void printColumn(int column);
 
 	real sumColumn(int column);
 
+	/**
+	 * Packs all column entries into one index array and one value array (CSC layout), with
+	 * columns becoming views into them.  INDICATOR columns at or above the bitmap density
+	 * become BITMAP columns first, and long remaining ones PACKED when packing is on.  Called
+	 * by the readers once parsing is complete, and again to repack after changing either
+	 * setting; columns modified afterwards copy their entries back out.
+	 */
+	void finalize();
+
 	/**
 	 * To sort by any arbitrary measure:
 	 * 1. Construct a std::map<CompressedDataColumn*, measure>
@@ -222,6 +427,7 @@ public:
 	void sortColumns(Comparator cmp) {
 		std::sort(allColumns.begin(), allColumns.end(),
 				cmp);		
+		releaseRows();
 	}
 
 	const CompressedDataColumn& getColumn(int column) const {
@@ -247,6 +453,9 @@ public:
 			push_back(i, NULL, INDICATOR);
 		} else if (colFormat == INTERCEPT) {
 			push_back(NULL, NULL, INTERCEPT);
+		} else if (colFormat == BITMAP || colFormat == PACKED) {
+			int_vector* i = new int_vector();
+			push_back(i, NULL, colFormat);
 		} else {
 			cerr << "Error" << endl;
 			exit(-1);
@@ -259,6 +468,7 @@ public:
 		}
 		allColumns.erase(allColumns.begin() + column);
 		nCols--;
+		releaseRows();
 	}
 
 protected:
@@ -266,6 +476,7 @@ protected:
 	void push_back(int_vector* colIndices, real_vector* colData, FormatType colFormat) {
 		allColumns.push_back(new CompressedDataColumn(colIndices, colData, colFormat));	
 		nCols++;
+		releaseRows();
 	}
 	
 	int nRows;
@@ -273,6 +484,18 @@ protected:
 	int nEntries;
 	std::vector<CompressedDataColumn*> allColumns;
 
+	std::vector<size_t> indexPointers; // nCols + 1 offsets into indexArena
+	std::vector<size_t> dataPointers; // nCols + 1 offsets into dataArena
+	int_vector indexArena;
+	real_vector dataArena;
+	std::shared_ptr<void> mappedArena; // Set when column entries live in a mapped file
+
+	mutable std::shared_ptr<const CompressedDataRows> rows; // Lazily built row-major mirror
+	mutable std::mutex rowsMutex;
+	size_t rowMajorBudget;
+	double bitmapDensity;
+	bool packIndices;
+
 private:
 	// Disable copy-constructors and copy-assignment
 	CompressedDataMatrix(const CompressedDataMatrix&);
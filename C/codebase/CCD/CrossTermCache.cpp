@@ -0,0 +1,106 @@
+/*
+ * CrossTermCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include "CrossTermCache.h"
+
+namespace bsccs {
+
+CrossTermCache::CrossTermCache(size_t budgetBytes) : budget(budgetBytes), usedBytes(0),
+		pooledBytes(0) {
+	// Do nothing
+}
+
+CrossTermCache::~CrossTermCache() {
+	// Do nothing
+}
+
+void CrossTermCache::setBudget(size_t budgetBytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	budget = budgetBytes;
+	evict(budget);
+}
+
+size_t CrossTermCache::getBudget(void) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return budget;
+}
+
+CrossTermCache::EntryPtr CrossTermCache::find(int index) {
+	std::lock_guard<std::mutex> lock(mutex);
+	SlotMap::iterator it = slots.find(index);
+	if (it == slots.end()) {
+		return EntryPtr();
+	}
+	recency.splice(recency.begin(), recency, it->second.position);
+	return it->second.entry;
+}
+
+std::shared_ptr<CrossTermCache::Entry> CrossTermCache::allocate(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (pool.empty()) {
+		return std::make_shared<Entry>();
+	}
+	std::shared_ptr<Entry> entry = pool.back();
+	pool.pop_back();
+	pooledBytes -= entry->bytes();
+	return entry;
+}
+
+CrossTermCache::EntryPtr CrossTermCache::insert(int index,
+		const std::shared_ptr<Entry>& entry) {
+	std::lock_guard<std::mutex> lock(mutex);
+	SlotMap::iterator it = slots.find(index);
+	if (it != slots.end()) { // Lost a race to another thread
+		recency.splice(recency.begin(), recency, it->second.position);
+		return it->second.entry;
+	}
+
+	const size_t bytes = entry->bytes();
+	if (bytes > budget) {
+		return entry;
+	}
+
+	evict(budget - bytes);
+	recency.push_front(index);
+	Slot slot = { entry, recency.begin() };
+	slots.insert(std::make_pair(index, slot));
+	usedBytes += bytes;
+	return entry;
+}
+
+void CrossTermCache::clear(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	evict(0);
+}
+
+void CrossTermCache::evict(size_t budgetBytes) {
+	while (!pool.empty() && usedBytes + pooledBytes > budgetBytes) {
+		pooledBytes -= pool.back()->bytes();
+		pool.pop_back();
+	}
+	while (usedBytes > budgetBytes && !recency.empty()) {
+		SlotMap::iterator it = slots.find(recency.back());
+		usedBytes -= it->second.entry->bytes();
+		recycle(it->second.entry);
+		slots.erase(it);
+		recency.pop_back();
+	}
+}
+
+void CrossTermCache::recycle(std::shared_ptr<Entry>& entry) {
+	const size_t bytes = entry->bytes();
+	if (entry.use_count() == 1 // Not held outside the cache
+			&& usedBytes + pooledBytes + bytes <= budget) {
+		entry->groups.clear();
+		entry->values.clear();
+		pool.push_back(entry);
+		pooledBytes += bytes;
+	}
+	entry.reset();
+}
+
+} // namespace
@@ -0,0 +1,99 @@
+/*
+ * CrossTermCache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef CROSSTERMCACHE_H_
+#define CROSSTERMCACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace bsccs {
+
+#ifdef DOUBLE_PRECISION
+	typedef double real;
+#else
+	typedef float real;
+#endif
+
+/*
+ * Bounded least-recently-used cache of per-covariate, per-stratum cross-terms used in the
+ * Fisher information of models with strata.  Entries are handed out as shared pointers, so
+ * an entry evicted while in use stays valid for its holder; evicted entries nobody holds go
+ * back to a pool and are refilled without reallocating.  Cached and pooled entries together
+ * stay within the budget.  All members are thread-safe.
+ */
+class CrossTermCache {
+public:
+	struct Entry {
+		std::vector<int> groups; // Strata, increasing
+		std::vector<real> values;
+
+		size_t bytes() const {
+			return groups.capacity() * sizeof(int) + values.capacity() * sizeof(real);
+		}
+	};
+
+	typedef std::shared_ptr<const Entry> EntryPtr;
+
+	CrossTermCache(size_t budgetBytes);
+
+	virtual ~CrossTermCache();
+
+	// Shrinking the budget evicts immediately
+	void setBudget(size_t budgetBytes);
+
+	size_t getBudget(void) const;
+
+	// Marks index as most recently used; NULL on a miss
+	EntryPtr find(int index);
+
+	// An empty entry to fill and insert(), recycled from the pool where possible
+	std::shared_ptr<Entry> allocate(void);
+
+	/**
+	 * Adds a filled entry for index and evicts least-recently-used entries down to the budget.
+	 * Returns the cached entry, which is the existing one when another thread inserted index
+	 * first.  An entry larger than the whole budget is returned but not kept.
+	 */
+	EntryPtr insert(int index, const std::shared_ptr<Entry>& entry);
+
+	void clear(void);
+
+private:
+	typedef std::list<int> Recency; // Most recently used first
+
+	struct Slot {
+		std::shared_ptr<Entry> entry;
+		Recency::iterator position;
+	};
+
+	typedef std::unordered_map<int, Slot> SlotMap;
+
+	void evict(size_t budgetBytes); // Caller holds mutex
+
+	void recycle(std::shared_ptr<Entry>& entry); // Caller holds mutex
+
+	size_t budget;
+	size_t usedBytes;
+	size_t pooledBytes;
+	SlotMap slots;
+	Recency recency;
+	std::vector<std::shared_ptr<Entry> > pool;
+	mutable std::mutex mutex;
+
+	// Disable copy-constructors and copy-assignment
+	CrossTermCache(const CrossTermCache&);
+	CrossTermCache& operator = (const CrossTermCache&);
+};
+
+} // namespace
+
+#endif /* CROSSTERMCACHE_H_ */
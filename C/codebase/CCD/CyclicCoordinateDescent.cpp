@@ -13,7 +13,8 @@
 #include <cstring>
 #include <map>
 #include <time.h>
-#include <set>
+#include <algorithm>
+#include <thread>
 
 #include "CyclicCoordinateDescent.h"
 #include "io/InputReader.h"
@@ -51,11 +52,13 @@ CyclicCoordinateDescent::CyclicCoordinateDescent(
 			ModelData* reader,
 			AbstractModelSpecifics& specifics,
 			priors::JointPriorPtr prior
-		) : modelSpecifics(specifics), jointPrior(prior) {
+		) : modelSpecifics(specifics), ownedModelSpecifics(NULL), ownedModelData(NULL),
+			jointPrior(prior) {
 	N = reader->getNumberOfPatients();
 	K = reader->getNumberOfRows();
 	J = reader->getNumberOfColumns();
 	
+	modelData = reader;
 	hXI = reader;
 	hY = reader->getYVector(); // TODO Delegate all data to ModelSpecifics
 	hOffs = reader->getOffsetVector();
@@ -106,14 +109,60 @@ CyclicCoordinateDescent::~CyclicCoordinateDescent(void) {
 		free(hWeights);
 	}
 
-#ifdef SPARSE_PRODUCT
-	for (std::vector<std::vector<int>* >::iterator it = sparseIndices.begin();
-			it != sparseIndices.end(); ++it) {
-		if (*it) {
-			delete *it;
+	if (ownedModelSpecifics) {
+		delete ownedModelSpecifics;
+	}
+
+	if (ownedModelData) { // Last, since model specifics refer to it
+		delete ownedModelData;
+	}
+}
+
+CyclicCoordinateDescent* CyclicCoordinateDescent::clone(ModelData* data) {
+	AbstractModelSpecifics* specifics = modelSpecifics.clone(*data);
+	CyclicCoordinateDescent* copy = new CyclicCoordinateDescent(data, *specifics,
+			jointPrior->clone());
+	copy->ownedModelSpecifics = specifics;
+	copySettings(*copy);
+	return copy;
+}
+
+CyclicCoordinateDescent* CyclicCoordinateDescent::cloneOnRows(const real* weights,
+		std::vector<real>* rowWeights) {
+	std::vector<int> rows;
+	std::vector<real> nonZeroWeights;
+	bool allOne = true;
+	for (int k = 0; k < K; ++k) {
+		if (weights[k] != 0.0) {
+			rows.push_back(k);
+			nonZeroWeights.push_back(weights[k]);
+			allOne = allOne && (weights[k] == 1.0);
 		}
 	}
-#endif
+	if (rows.empty()) {
+		cerr << "No rows with non-zero weight" << endl;
+		exit(-1);
+	}
+
+	ModelData* subset = modelData->getRowSubset(rows);
+	CyclicCoordinateDescent* copy = clone(subset);
+	copy->ownedModelData = subset;
+	if (!allOne) {
+		copy->setWeights(&nonZeroWeights[0]);
+	}
+	if (rowWeights) {
+		rowWeights->swap(nonZeroWeights);
+	}
+	return copy;
+}
+
+void CyclicCoordinateDescent::copySettings(CyclicCoordinateDescent& copy) const {
+	copy.noiseLevel = noiseLevel;
+	copy.priorType = priorType;
+	copy.fixBeta = fixBeta;
+	copy.useActiveSet = useActiveSet;
+	copy.setThreads(nThreads);
+	copy.setBeta(hBeta);
 }
 
 void CyclicCoordinateDescent::setNoiseLevel(NoiseLevels noise) {
@@ -174,31 +223,14 @@ void CyclicCoordinateDescent::init(bool offset) {
 	wPid = (real*) malloc(sizeof(real) * alignedLength);
 #endif
 
-	// TODO Suspect below is not necessary for non-grouped data.
-	// If true, then fill with pointers to CompressedDataColumn and do not delete in destructor
-	for (int j = 0; j < J; ++j) {
-		if (hXI->getFormatType(j) == DENSE) {
-			sparseIndices.push_back(NULL);
-		} else {
-			std::set<int> unique;
-			const int n = hXI->getNumberOfEntries(j);
-			const int* indicators = hXI->getCompressedColumnVector(j);
-			for (int j = 0; j < n; j++) { // Loop through non-zero entries only
-				const int k = indicators[j];
-				const int i = hPid[k];
-				unique.insert(i);
-			}
-			std::vector<int>* indices = new std::vector<int>(unique.begin(),
-					unique.end());
-			sparseIndices.push_back(indices);
-		}
-	}
-
 	useCrossValidation = false;
 	validWeights = false;
 	sufficientStatisticsKnown = false;
 	fisherInformationKnown = false;
 	varianceKnown = false;
+	varianceColumnIndex = -1;
+	useDenseVariance = false;
+	nThreads = 1;
 	if (offset) {
 		hBeta[0] = static_cast<double>(1);
 		fixBeta[0] = true;
@@ -207,6 +239,7 @@ void CyclicCoordinateDescent::init(bool offset) {
 		xBetaKnown = true; // all beta = 0 => xBeta = 0
 	}
 	doLogisticRegression = false;
+	useActiveSet = false;
 
 #ifdef DEBUG	
 #ifndef MY_RCPP_FLAG
@@ -277,23 +310,19 @@ void CyclicCoordinateDescent::logResults(const char* fileName, bool withASE) {
 
 double CyclicCoordinateDescent::getPredictiveLogLikelihood(real* weights) {
 
-	if (!xBetaKnown) {
-		computeXBeta();
-		xBetaKnown = true;
-		sufficientStatisticsKnown = false;
-	}
-
-	if (!sufficientStatisticsKnown) {
-		computeRemainingStatistics(true, 0); // TODO Remove index????
-		sufficientStatisticsKnown = true;
-	}
+	checkAllLazyFlags(); // Weights may have changed since the last update()
 
 	getDenominators();
 
 	return modelSpecifics.getPredictiveLogLikelihood(weights); // TODO Pass double
 }
 
-void CyclicCoordinateDescent::getPredictiveEstimates(real* y, real* weights) const {
+void CyclicCoordinateDescent::getPredictiveEstimates(real* y, real* weights) {
+	if (!xBetaKnown) { // e.g. after setBeta()
+		computeXBeta();
+		xBetaKnown = true;
+		sufficientStatisticsKnown = false;
+	}
 	modelSpecifics.getPredictiveEstimates(y, weights);
 }
 
@@ -376,6 +405,15 @@ void CyclicCoordinateDescent::makeDirty(void) {
 	sufficientStatisticsKnown = false;
 }
 
+void CyclicCoordinateDescent::setUseActiveSet(bool value) {
+	useActiveSet = value;
+}
+
+void CyclicCoordinateDescent::setThreads(int threads) {
+	nThreads = threads;
+	modelSpecifics.setThreads(threads);
+}
+
 void CyclicCoordinateDescent::setPriorType(int iPriorType) {
 	if (iPriorType < NONE || iPriorType > NORMAL) {
 		cerr << "Unknown prior type" << endl;
@@ -515,6 +553,16 @@ void CyclicCoordinateDescent::update(
 
 	resetBounds();
 
+	if (useActiveSet) {
+		screenActiveSet();
+	} else {
+		activeSet.resize(J);
+		for (int j = 0; j < J; ++j) {
+			activeSet[j] = j;
+		}
+	}
+	partitionActiveSet();
+
 	bool done = false;
 	int iteration = 0;
 	double lastObjFunc;
@@ -528,22 +576,7 @@ void CyclicCoordinateDescent::update(
 	while (!done) {
 	
 		// Do a complete cycle
-		for(int index = 0; index < J; index++) {
-		
-			if (!fixBeta[index]) {
-				double delta = ccdUpdateBeta(index);
-				delta = applyBounds(delta, index);
-				if (delta != 0.0) {
-					sufficientStatisticsKnown = false;
-					updateSufficientStatistics(delta, index);
-				}
-			}
-			
-			if ( (noiseLevel > QUIET) && ((index+1) % 100 == 0)) {
-				cout << "Finished variable " << (index+1) << endl;
-			}
-			
-		}
+		updateCycle();
 
 		iteration++;
 //		bool checkConvergence = (iteration % J == 0 || iteration == maxIterations);
@@ -582,7 +615,14 @@ void CyclicCoordinateDescent::update(
 						<< ") (iter:" << iteration << ") ";
 			}
 
-			if (epsilon > 0 && conv < epsilon) {
+			if (epsilon > 0 && conv < epsilon && useActiveSet && !illconditioned
+					&& iteration < maxIterations && addKktViolators() > 0) {
+				// Converged on the active set, but not over all covariates
+				partitionActiveSet();
+				if (noiseLevel > QUIET) {
+					cout << endl << "Active set grown to " << activeSet.size() << " covariates" << endl;
+				}
+			} else if (epsilon > 0 && conv < epsilon) {
 				if (illconditioned) {
 					lastReturnFlag = ILLCONDITIONED;
 				} else {
@@ -659,9 +699,25 @@ double CyclicCoordinateDescent::getAsymptoticVariance(int indexOne, int indexTwo
 
 	if (itOne == hessianIndexMap.end() || itTwo == hessianIndexMap.end()) {
 		return NAN;
-	} else {
+	}
+
+	if (useDenseVariance) {
 		return varianceMatrix(itOne->second, itTwo->second);
 	}
+
+	if (hessianFactor.info() != Eigen::Success) {
+		return NAN;
+	}
+
+	// Solve for one column of the inverse and keep it for the next request
+	const int column = itTwo->second;
+	if (column != varianceColumnIndex) {
+		Eigen::VectorXd unit = Eigen::VectorXd::Zero(hessianMatrix.rows());
+		unit(column) = 1.0;
+		varianceColumn = hessianFactor.solve(unit);
+		varianceColumnIndex = column;
+	}
+	return varianceColumn(itOne->second);
 }
 
 double CyclicCoordinateDescent::getAsymptoticPrecision(int indexOne, int indexTwo) {
@@ -677,10 +733,84 @@ double CyclicCoordinateDescent::getAsymptoticPrecision(int indexOne, int indexTw
 	if (itOne == hessianIndexMap.end() || itTwo == hessianIndexMap.end()) {
 		return NAN;
 	} else {
-		return hessianMatrix(itOne->second, itTwo->second);
+		return hessianMatrix.coeff(std::min(itOne->second, itTwo->second),
+				std::max(itOne->second, itTwo->second));
+	}
+}
+
+namespace {
+
+/*
+ * Which covariate pairs may have non-zero Fisher information: those reaching a common
+ * row (or stratum), and any pair involving a covariate that reaches all of them
+ */
+struct FisherInformationPattern {
+	std::vector<std::vector<int> > groups; // Covariate -> groups reached
+	std::vector<std::vector<int> > owners; // Group -> covariates reaching it, increasing
+	std::vector<int> reachesAll; // Covariates reaching every group, increasing
+	std::vector<char> isReachingAll;
+};
+
+// Groups of covariates first, first + stride, ...; also fills the model's cross-term cache
+void computeFisherInformationGroups(AbstractModelSpecifics* specifics,
+		const std::vector<int>* indices, FisherInformationPattern* pattern, int first, int stride) {
+	for (int ii = first; ii < static_cast<int>(indices->size()); ii += stride) {
+		pattern->isReachingAll[ii] =
+				!specifics->getFisherInformationGroups((*indices)[ii], &pattern->groups[ii]);
 	}
 }
 
+// Upper-triangle entries of rows first, first + stride, ... of the Fisher information
+void computeFisherInformationRows(AbstractModelSpecifics* specifics,
+		const std::vector<int>* indices, const FisherInformationPattern* pattern,
+		bool useWeights, int first, int stride, std::vector<Eigen::Triplet<double> >* triplets) {
+
+	const int P = indices->size();
+	std::vector<int> lastRow(P, -1); // Row at which each column was last listed
+	std::vector<int> columns;
+
+	for (int ii = first; ii < P; ii += stride) {
+		columns.clear();
+		if (pattern->isReachingAll[ii]) {
+			for (int jj = ii; jj < P; ++jj) {
+				columns.push_back(jj);
+			}
+		} else {
+			columns.push_back(ii); // Keep the diagonal even when zero
+			lastRow[ii] = ii;
+			for (std::vector<int>::const_iterator it = pattern->reachesAll.begin();
+					it != pattern->reachesAll.end(); ++it) {
+				if (*it > ii) {
+					columns.push_back(*it);
+					lastRow[*it] = ii;
+				}
+			}
+			const std::vector<int>& groups = pattern->groups[ii];
+			for (std::vector<int>::const_iterator group = groups.begin(); group != groups.end(); ++group) {
+				const std::vector<int>& owners = pattern->owners[*group];
+				for (std::vector<int>::const_iterator it = std::upper_bound(owners.begin(),
+						owners.end(), ii); it != owners.end(); ++it) {
+					if (lastRow[*it] != ii) {
+						columns.push_back(*it);
+						lastRow[*it] = ii;
+					}
+				}
+			}
+		}
+
+		for (std::vector<int>::const_iterator jj = columns.begin(); jj != columns.end(); ++jj) {
+			double fisherInformation = 0.0;
+			specifics->computeFisherInformation((*indices)[ii], (*indices)[*jj],
+					&fisherInformation, useWeights);
+			if (fisherInformation != 0.0 || *jj == ii) {
+				triplets->push_back(Eigen::Triplet<double>(ii, *jj, fisherInformation));
+			}
+		}
+	}
+}
+
+} // namespace
+
 void CyclicCoordinateDescent::computeAsymptoticPrecisionMatrix(void) {
 
 	typedef std::vector<int> int_vec;
@@ -697,43 +827,122 @@ void CyclicCoordinateDescent::computeAsymptoticPrecisionMatrix(void) {
 		}
 	}
 
-	hessianMatrix.resize(indices.size(), indices.size());
+	const int P = indices.size();
 	modelSpecifics.makeDirty(); // clear hessian terms
 
-	for (int ii = 0; ii < indices.size(); ++ii) {
-		for (int jj = ii; jj < indices.size(); ++jj) {
-			const int i = indices[ii];
-			const int j = indices[jj];
-//			std::cerr << "(" << i << "," << j << ")" << std::endl;
-			double fisherInformation = 0.0;
-			modelSpecifics.computeFisherInformation(i, j, &fisherInformation, useCrossValidation);
-//			if (fisherInformation != 0.0) {
-				// Add tuple to sparse matrix
-//				tripletList.push_back(Triplet<double>(ii,jj,fisherInformation));
-//			}
-			hessianMatrix(jj,ii) = hessianMatrix(ii,jj) = fisherInformation;
-
-//			std::cerr << "Info = " << fisherInformation << std::endl;
-//			std::cerr << "Hess = " << getHessianDiagonal(0) << std::endl;
-//			exit(-1);
+	// Bulk pass: group structure of each covariate, which also fills the model's cross-term
+	// cache ahead of the pairwise loop
+	FisherInformationPattern pattern;
+	pattern.groups.resize(P);
+	pattern.isReachingAll.resize(P, false);
+
+	// Rows are striped across threads to balance the triangle
+	const int threads = std::max(1, std::min(nThreads, P));
+	if (threads == 1) {
+		computeFisherInformationGroups(&modelSpecifics, &indices, &pattern, 0, 1);
+	} else {
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; ++t) {
+			workers.push_back(std::thread(computeFisherInformationGroups, &modelSpecifics,
+					&indices, &pattern, t, threads));
+		}
+		for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+			it->join();
 		}
 	}
 
-//	sm.setFromTriplets(tripletList.begin(), tripletList.end());
-//	cout << sm;
-//	auto inv = sm.triangularView<Upper>().solve(dv1);
-//	cout << sm.inverse();
-//	cout << hessianMatrix << endl;
+	for (int ii = 0; ii < P; ++ii) {
+		if (pattern.isReachingAll[ii]) {
+			pattern.reachesAll.push_back(ii);
+		} else {
+			const std::vector<int>& groups = pattern.groups[ii];
+			for (std::vector<int>::const_iterator it = groups.begin(); it != groups.end(); ++it) {
+				if (*it >= static_cast<int>(pattern.owners.size())) {
+					pattern.owners.resize(*it + 1);
+				}
+				pattern.owners[*it].push_back(ii);
+			}
+		}
+	}
 
-	// Take inverse
-//	hessianMatrix = hessianMatrix.inverse();
+	std::vector<std::vector<Eigen::Triplet<double> > > triplets(threads);
+	if (threads == 1) {
+		computeFisherInformationRows(&modelSpecifics, &indices, &pattern, useCrossValidation,
+				0, 1, &triplets[0]);
+	} else {
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; ++t) {
+			workers.push_back(std::thread(computeFisherInformationRows, &modelSpecifics,
+					&indices, &pattern, useCrossValidation, t, threads, &triplets[t]));
+		}
+		for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+			it->join();
+		}
+	}
 
-//	cout << hessianMatrix << endl;
+	for (int t = 1; t < threads; ++t) {
+		triplets[0].insert(triplets[0].end(), triplets[t].begin(), triplets[t].end());
+	}
+	hessianMatrix.resize(P, P);
+	hessianMatrix.setFromTriplets(triplets[0].begin(), triplets[0].end());
 }
 
+const double CyclicCoordinateDescent::denseVarianceFraction = 0.1;
+
 void CyclicCoordinateDescent::computeAsymptoticVarianceMatrix(void) {
-	varianceMatrix = hessianMatrix.inverse();
-// 	cout << varianceMatrix << endl;
+	const double P = hessianMatrix.rows();
+	useDenseVariance = hessianMatrix.nonZeros() > denseVarianceFraction * P * (P + 1) / 2;
+	varianceColumnIndex = -1;
+
+	if (useDenseVariance) {
+		Matrix upper = Matrix(hessianMatrix);
+		Matrix full = upper.selfadjointView<Eigen::Upper>();
+		varianceMatrix = full.inverse();
+	} else {
+		varianceMatrix.resize(0, 0);
+		hessianFactor.compute(hessianMatrix);
+	}
+}
+
+void CyclicCoordinateDescent::updateCycle(void) {
+	int count = 0;
+	for (int f = 0; f < CYCLE_FORMAT_COUNT; ++f) {
+		const std::vector<int>& columns = activeSetByFormat[cycleFormatOrder[f]];
+		for (int i = 0; i < static_cast<int>(columns.size()); i++) {
+			const int index = columns[i];
+
+			if (!fixBeta[index]) {
+				double delta = ccdUpdateBeta(index);
+				delta = applyBounds(delta, index);
+				if (delta != 0.0) {
+					sufficientStatisticsKnown = false;
+					updateSufficientStatistics(delta, index);
+				}
+			}
+
+			if ( (noiseLevel > QUIET) && (++count % 100 == 0)) {
+				cout << "Finished variable " << count << endl;
+			}
+		}
+	}
+}
+
+void CyclicCoordinateDescent::partitionActiveSet(void) {
+	std::vector<bool> active(J, false);
+	for (std::vector<int>::const_iterator it = activeSet.begin(); it != activeSet.end(); ++it) {
+		active[*it] = true;
+	}
+
+	for (int f = 0; f < CYCLE_FORMAT_COUNT; ++f) {
+		const FormatType format = cycleFormatOrder[f];
+		const std::vector<int> columns = hXI->getColumnsByFormat(format);
+		activeSetByFormat[format].clear();
+		for (std::vector<int>::const_iterator it = columns.begin(); it != columns.end(); ++it) {
+			if (active[*it]) {
+				activeSetByFormat[format].push_back(*it);
+			}
+		}
+	}
 }
 
 double CyclicCoordinateDescent::ccdUpdateBeta(int index) {
@@ -751,6 +960,60 @@ double CyclicCoordinateDescent::ccdUpdateBeta(int index) {
 	return jointPrior->getDelta(gh, hBeta[index], index);
 }
 
+double CyclicCoordinateDescent::computeGradient(int index) {
+	computeNumeratorForGradient(index);
+
+	double gradient, hessian;
+	computeGradientAndHessian(index, &gradient, &hessian);
+	return gradient;
+}
+
+void CyclicCoordinateDescent::screenActiveSet(void) {
+	// Sequential strong rule (Tibshirani et al., 2012): discard zero coefficients with
+	// |gradient| < 2 * threshold - previous threshold.  Discarded covariates are
+	// re-examined by addKktViolators() before convergence is declared.
+	const bool havePrevious = (static_cast<int>(lastSparsityThreshold.size()) == J);
+	lastSparsityThreshold.resize(J);
+
+	activeSet.clear();
+	for (int j = 0; j < J; ++j) {
+		const double threshold = jointPrior->getSparsityThreshold(j);
+		const double previous = havePrevious ? lastSparsityThreshold[j] : threshold;
+		lastSparsityThreshold[j] = threshold;
+
+		if (!fixBeta[j] && (hBeta[j] != 0.0 ||
+				std::abs(computeGradient(j)) >= 2.0 * threshold - previous)) {
+			activeSet.push_back(j);
+		}
+	}
+
+	if (noiseLevel > QUIET) {
+		cout << "Active set contains " << activeSet.size() << " of " << J << " covariates" << endl;
+	}
+}
+
+int CyclicCoordinateDescent::addKktViolators(void) {
+	// Zero coefficients outside the active set must satisfy |gradient| <= threshold
+	std::vector<bool> active(J, false);
+	for (std::vector<int>::const_iterator it = activeSet.begin(); it != activeSet.end(); ++it) {
+		active[*it] = true;
+	}
+
+	int violations = 0;
+	for (int j = 0; j < J; ++j) {
+		if (!active[j] && !fixBeta[j] &&
+				std::abs(computeGradient(j)) > jointPrior->getSparsityThreshold(j)) {
+			activeSet.push_back(j);
+			++violations;
+		}
+	}
+
+	if (violations > 0) {
+		std::sort(activeSet.begin(), activeSet.end()); // Keep cyclic order
+	}
+	return violations;
+}
+
 template <class IteratorType>
 void CyclicCoordinateDescent::axpy(real* y, const real alpha, const int index) {
 	IteratorType it(*hXI, index);
@@ -766,12 +1029,21 @@ void CyclicCoordinateDescent::axpyXBeta(const real beta, const int j) {
 		case INDICATOR:
 			axpy < IndicatorIterator > (hXBeta, beta, j);
 			break;
+		case BITMAP:
+			axpy < BitmapIterator > (hXBeta, beta, j);
+			break;
+		case PACKED:
+			axpy < PackedIterator > (hXBeta, beta, j);
+			break;
 		case DENSE:
 			axpy < DenseIterator > (hXBeta, beta, j);
 			break;
 		case SPARSE:
 			axpy < SparseIterator > (hXBeta, beta, j);
 			break;
+		case INTERCEPT:
+			axpy < InterceptIterator > (hXBeta, beta, j);
+			break;
 		default:
 			// throw error
 			exit(-1);
@@ -779,16 +1051,36 @@ void CyclicCoordinateDescent::axpyXBeta(const real beta, const int j) {
 	}
 }
 
-void CyclicCoordinateDescent::computeXBeta(void) {
-	// Note: X is current stored in (sparse) column-major format, which is
-	// inefficient for forming X\beta.
-	// TODO Make row-major version of X
+bool CyclicCoordinateDescent::useRowMajorXBeta(void) const {
+	// Column-wise axpy skips zero coefficients, so prefer it for sparse beta
+	size_t entries = 0;
+	size_t nonZeroEntries = 0;
+	for (int j = 0; j < J; ++j) {
+		const size_t size = hXI->getColumnSize(j);
+		entries += size;
+		if (static_cast<real>(hBeta[j]) != static_cast<real>(0)) {
+			nonZeroEntries += size;
+		}
+	}
+	return 2 * nonZeroEntries > entries;
+}
 
+void CyclicCoordinateDescent::computeXBeta(void) {
 	if (setBetaList.empty()) { // Update all
-		// clear X\beta
-		zeroVector(hXBeta, K);
-		for (int j = 0; j < J; ++j) {
-			axpyXBeta(hBeta[j], j);
+		// X is stored column-major; rows of the row-major mirror are summed without
+		// write conflicts across threads
+		std::shared_ptr<const CompressedDataRows> rows;
+		if (useRowMajorXBeta()) {
+			rows = hXI->getRows(nThreads);
+		}
+		if (rows) {
+			rows->multiply(&hBeta[0], hXBeta, nThreads);
+		} else {
+			// clear X\beta
+			zeroVector(hXBeta, K);
+			for (int j = 0; j < J; ++j) {
+				axpyXBeta(hBeta[j], j);
+			}
 		}
 	} else {
 		while (!setBetaList.empty()) {
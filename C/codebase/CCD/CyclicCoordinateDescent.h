@@ -14,6 +14,7 @@
 #include "priors/JointPrior.h"
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 #include <deque>
 
 namespace bsccs {
@@ -72,6 +73,12 @@ enum UpdateReturnFlags {
 	MISSING_COVARIATES
 };
 
+// Order in which each cycle visits the per-format runs of the active set
+enum { CYCLE_FORMAT_COUNT = 6 };
+static const FormatType cycleFormatOrder[CYCLE_FORMAT_COUNT] = {
+	INTERCEPT, INDICATOR, BITMAP, PACKED, SPARSE, DENSE
+};
+
 //enum ModelType {
 //	MSCCS, // multiple self-controlled case series
 //	CLR,   // conditional logistic regression
@@ -112,12 +119,30 @@ public:
 	void logResults(const char* fileName, bool withASE);
 
 	virtual ~CyclicCoordinateDescent();
+
+	// Independent engine (own model specifics and prior) sharing the same read-only data
+	CyclicCoordinateDescent* clone() {
+		return clone(modelData);
+	}
+
+	// As above, but over data, which must outlive the copy
+	virtual CyclicCoordinateDescent* clone(ModelData* data);
+
+	/**
+	 * Independent engine over only the rows with non-zero weight, so that fits on training
+	 * subsets (cross-validation folds, bootstrap replicates) never touch excluded rows.  Rows
+	 * are renumbered and each column keeps just its entries in those rows; the engine owns
+	 * this compact data.  The non-zero weights are installed on the engine unless all equal 1
+	 * and are also returned in rowWeights when given.
+	 */
+	CyclicCoordinateDescent* cloneOnRows(const real* weights,
+			std::vector<real>* rowWeights = NULL);
 	
 	double getLogLikelihood(void);
 
 	double getPredictiveLogLikelihood(real* weights);
 
-	void getPredictiveEstimates(real* y, real* weights) const;
+	void getPredictiveEstimates(real* y, real* weights);
 
 	double getLogPrior(void);
 	
@@ -154,6 +179,10 @@ public:
 
 	void setLogisticRegression(bool idoLR);
 
+	void setUseActiveSet(bool value);
+
+	void setThreads(int threads);
+
 //	template <typename T>
 	void setBeta(const std::vector<double>& beta);
 
@@ -194,16 +223,29 @@ public:
 protected:
 	
 	AbstractModelSpecifics& modelSpecifics;
+	AbstractModelSpecifics* ownedModelSpecifics; // Only set for clones
+	ModelData* ownedModelData; // Only set for row-subset clones
 	priors::JointPriorPtr jointPrior;
 //	ModelSpecifics<DefaultModel>& modelSpecifics;
 //private:
 	
 	void init(bool offset);
+
+	void copySettings(CyclicCoordinateDescent& copy) const;
 	
 	void resetBounds(void);
 
+	// Splits activeSet into per-format runs, visited by updateCycle() one format at a time
+	void partitionActiveSet(void);
+
+	// One pass of coordinate updates over the active set
+	virtual void updateCycle(void);
+
 	void computeXBeta(void);
 
+	// Whether a full X\beta pays for a pass over all rows of the row-major mirror
+	bool useRowMajorXBeta(void) const;
+
 	void saveXBeta(void);
 
 	void computeFixedTermsInLogLikelihood(void);
@@ -220,6 +262,7 @@ protected:
 
 	void computeAsymptoticPrecisionMatrix(void);
 
+	// Factorizes the Fisher information; entries of its inverse are solved on request
 	void computeAsymptoticVarianceMatrix(void);
 
 	template <class IteratorType>
@@ -275,6 +318,12 @@ protected:
 	void checkAllLazyFlags(void);
 
 	double ccdUpdateBeta(int index);
+
+	double computeGradient(int index);
+
+	void screenActiveSet(void);
+
+	int addKktViolators(void);
 	
 	double applyBounds(
 			double inDelta,
@@ -323,6 +372,7 @@ protected:
 	ofstream outLog;
 	bool hasLog;
 
+	ModelData* modelData;
 	CompressedDataMatrix* hXI; // K-by-J-indicator matrix
 
 	real* hOffs;  // K-vector
@@ -381,18 +431,33 @@ protected:
 	UpdateReturnFlags lastReturnFlag;
 	int lastIterationCount;
 
+	bool useActiveSet;
+	std::vector<int> activeSet; // Covariates visited in each cycle
+	std::vector<int> activeSetByFormat[CYCLE_FORMAT_COUNT]; // activeSet partitioned by FormatType
+	DoubleVector lastSparsityThreshold; // Thresholds at the previous update, for the sequential strong rule
+
 #ifdef SPARSE_PRODUCT
-	std::vector<std::vector<int>* > sparseIndices;
+	SparseIndices sparseIndices; // Built by modelSpecifics.initialize()
 #endif
 	
 #ifdef NO_FUSE
 	real* wPid;
 #endif
 
+	typedef Eigen::SparseMatrix<double> SparseMatrix;
+	SparseMatrix hessianMatrix; // Upper triangle of the Fisher information
+	Eigen::SimplicialLDLT<SparseMatrix, Eigen::Upper> hessianFactor;
+	int varianceColumnIndex; // Column of the inverse held in varianceColumn, or -1
+	Eigen::VectorXd varianceColumn;
+
+	// Above this fraction of non-zeros in the triangle, a dense inverse beats the sparse factor
+	const static double denseVarianceFraction;
+	bool useDenseVariance;
 	typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> Matrix;
-	Matrix hessianMatrix;
 	Matrix varianceMatrix;
 
+	int nThreads; // For assembling the Fisher information
+
 	typedef std::map<int, int> IndexMap;
 	IndexMap hessianIndexMap;
 
@@ -66,6 +66,13 @@ bool GPUCyclicCoordinateDescent::initializeDevice(int deviceNumber) {
 	size_t initial = gpu->GetAvailableMemory();
 	cerr << "Available = " << initial << endl;
 
+	// Device kernels walk lists of rows, so BITMAP and PACKED columns are unpacked
+	for (int j = 0; j < J; j++) {
+		if (hXI->getFormatType(j) == BITMAP || hXI->getFormatType(j) == PACKED) {
+			hXI->convertColumnToIndicator(j);
+		}
+	}
+
 #ifdef CONTIG_MEMORY
 	int nonZero = 0;
 	dXI = (GPUPtr*) malloc(J * sizeof(GPUPtr));
@@ -144,7 +151,7 @@ bool GPUCyclicCoordinateDescent::initializeDevice(int deviceNumber) {
 	int totalLength = 0;
 	maxNISize = 0;
 	for (int j = 0; j < J; ++j) {
-		const int size = sparseIndices[j]->size();
+		const int size = sparseIndices[j].size;
 		if (size > maxNISize) {
 			maxNISize = size;
 		}
@@ -159,15 +166,11 @@ bool GPUCyclicCoordinateDescent::initializeDevice(int deviceNumber) {
 	GPUPtr head = gpu->AllocateIntMemory(totalLength);
 	dNI = (GPUPtr*) malloc(J * sizeof(GPUPtr));
 	for (int j = 0; j < J; ++j) {
-		const int n = sparseIndices[j]->size();
+		const IndexList list = sparseIndices[j];
+		const int n = list.size;
 		if (n > 0) {
 			dNI[j] = head;
-			typedef std::vector<int>::iterator Iterator;
-			Iterator it = sparseIndices[j]->begin();
-			const Iterator end = sparseIndices[j]->end();
-			for (; it != end; ++it) {
-				hNI.push_back(*it);
-			}
+			hNI.insert(hNI.end(), list.indices, list.indices + n);
 		} else {
 			dNI[j] = NULL;
 		}
@@ -490,7 +493,7 @@ void GPUCyclicCoordinateDescent::computeGradientAndHession(int index, double *og
 #ifdef GPU_SPARSE_PRODUCT
 	int blockUsed = kernels->computeGradientAndHessianWithReductionSparse(dNumerPid, dDenomPid, dNEvents, dNI[index],
 			dGradient, dHessian,
-			sparseIndices[index]->size(),
+			sparseIndices[index].size,
 //			N,
 			1, SPARSE_WORK_BLOCK_SIZE);
 	gpu->MemcpyDeviceToHost(hGradient, dGradient, sizeof(real) * 2 * alignedGHCacheSize);
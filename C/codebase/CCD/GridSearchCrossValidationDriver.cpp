@@ -13,6 +13,8 @@
 #include <numeric>
 #include <math.h>
 #include <cstdlib>
+#include <algorithm>
+#include <thread>
 
 #include "GridSearchCrossValidationDriver.h"
 
@@ -33,15 +35,7 @@ GridSearchCrossValidationDriver::~GridSearchCrossValidationDriver() {
 }
 
 double GridSearchCrossValidationDriver::computeGridPoint(int step) {
-	if (gridSize == 1) {
-		return upperLimit;
-	}
-	// Linear grid
-//	double stepSize = (upperLimit - lowerLimit) / (gridSize - 1);
-//	return lowerLimit + step * stepSize;
-	// Log uniform grid
-	double stepSize = (log(upperLimit) - log(lowerLimit)) / (gridSize - 1);
-	return exp(log(lowerLimit) + step * stepSize);
+	return RegularizationPath::getPoint(step, gridSize, lowerLimit, upperLimit);
 }
 //double GridSearchCrossValidationDriver::computePointEstimate(const std::vector<double>& value) {
 //	// Mean of log values
@@ -85,8 +79,22 @@ void GridSearchCrossValidationDriver::resetForOptimal(
 	double maxPoint;
 	double maxValue;
 	findMax(&maxPoint, &maxValue);
-	ccd.setHyperprior(maxPoint);
-	ccd.resetBeta(); // Cold-start
+
+	if (arguments.usePath) {
+		// Warm-start by walking the full-data path up to the optimal point
+		int maxStep = 0;
+		while (gridPoint[maxStep] != maxPoint) {
+			++maxStep;
+		}
+		ccd.setBeta(startBeta);
+		RegularizationPath path(gridSize, lowerLimit, upperLimit);
+		RegularizationPath::NoObserver observer;
+		path.fit(ccd, arguments, observer, maxStep);
+		ccd.setHyperprior(maxPoint);
+	} else {
+		ccd.setHyperprior(maxPoint);
+		ccd.resetBeta(); // Cold-start
+	}
 }
 
 void GridSearchCrossValidationDriver::drive(
@@ -96,51 +104,55 @@ void GridSearchCrossValidationDriver::drive(
 
 	// TODO Check that selector is type of CrossValidationSelector
 
-	std::vector<real> weights;
+	startBeta.resize(ccd.getBetaSize());
+	for (int j = 0; j < ccd.getBetaSize(); ++j) {
+		startBeta[j] = ccd.getBeta(j);
+	}
 
-	for (int step = 0; step < gridSize; step++) {
+	// Fold-major: each fold draws its partition once, builds compact engines over its training
+	// and held-out rows, and walks every grid-point warm-started from its own previous fit.
+	// Results do not depend on the number of threads.
+	const int nThreads = std::max(1, std::min(arguments.threads, arguments.foldToCompute));
 
-		std::vector<double> predLogLikelihood;
-		double point = computeGridPoint(step);
-		ccd.setHyperprior(point);
+	std::vector<std::vector<double> > foldValue(arguments.foldToCompute,
+			std::vector<double>(gridSize));
+	std::vector<FoldTask> tasks(nThreads);
 
-		for (int i = 0; i < arguments.foldToCompute; i++) {
-			int fold = i % arguments.fold;
-			if (fold == 0) {
-				selector.permute(); // Permute every full cross-validation rep
-			}
+	for (int first = 0; first < arguments.foldToCompute; first += nThreads) {
+		const int nTasks = std::min(nThreads, arguments.foldToCompute - first);
 
-			// Get this fold and update
-			selector.getWeights(fold, weights);
-			if(weightsExclude){
-				for(int j = 0; j < (int)weightsExclude->size(); j++){
-					if(weightsExclude->at(j) == 1.0){
-						weights[j] = 0.0;
-					}
-				}
-			}
-			ccd.setWeights(&weights[0]);
-			std::cout << "Running at " << ccd.getPriorInfo() << " ";
-			ccd.update(arguments.maxIterations, arguments.convergenceType, arguments.tolerance);
-
-			// Compute predictive loglikelihood for this fold
-			selector.getComplement(weights);
-			if(weightsExclude){
-				for(int j = 0; j < (int)weightsExclude->size(); j++){
-					if(weightsExclude->at(j) == 1.0){
-						weights[j] = 0.0;
-					}
-				}
-			}
+		// Draw weights and build row-subsets in serial order, so selector behavior is unchanged
+		// and the workers only read the shared ModelData
+		for (int t = 0; t < nTasks; ++t) {
+			drawFold(selector, first + t, &tasks[t], arguments);
+			buildFold(ccd, &tasks[t], nThreads > 1);
+		}
+
+		std::vector<std::thread> workers;
+		for (int t = 1; t < nTasks; ++t) {
+			workers.push_back(std::thread(&GridSearchCrossValidationDriver::fitFold, this,
+					&tasks[t], &foldValue[first + t], &arguments));
+		}
+		fitFold(&tasks[0], &foldValue[first], &arguments);
+		for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+			it->join();
+		}
 
-			double logLikelihood = ccd.getPredictiveLogLikelihood(&weights[0]);
+		for (int t = 0; t < nTasks; ++t) {
+			delete tasks[t].training;
+			delete tasks[t].heldOut;
+		}
+	}
 
+	for (int step = 0; step < gridSize; step++) {
+		std::vector<double> predLogLikelihood;
+		double point = computeGridPoint(step);
+		for (int i = 0; i < arguments.foldToCompute; ++i) {
+			const double logLikelihood = foldValue[i][step];
 			std::cout << "Grid-point #" << (step + 1) << " at " << point;
-			std::cout << "\tFold #" << (fold + 1)
+			std::cout << "\tFold #" << (i % arguments.fold + 1)
 			          << " Rep #" << (i / arguments.fold + 1) << " pred log like = "
 			          << logLikelihood << std::endl;
-
-			// Store value
 			predLogLikelihood.push_back(logLikelihood);
 		}
 
@@ -150,7 +162,10 @@ void GridSearchCrossValidationDriver::drive(
 		gridValue.push_back(value);
 	}
 
-	// Report results
+	reportMax(arguments);
+}
+
+void GridSearchCrossValidationDriver::reportMax(const CCDArguments& arguments) {
 	double maxPoint;
 	double maxValue;
 	findMax(&maxPoint, &maxValue);
@@ -165,6 +180,65 @@ void GridSearchCrossValidationDriver::drive(
 	std:cout << std::endl;
 }
 
+void GridSearchCrossValidationDriver::drawFold(
+		AbstractSelector& selector,
+		int i,
+		FoldTask* task,
+		const CCDArguments& arguments) {
+
+	int fold = i % arguments.fold;
+	if (fold == 0) {
+		selector.permute(); // Permute every full cross-validation rep
+	}
+
+	// Get this fold and update
+	task->index = i;
+	selector.getWeights(fold, task->weights);
+	if(weightsExclude){
+		for(int j = 0; j < (int)weightsExclude->size(); j++){
+			if(weightsExclude->at(j) == 1.0){
+				task->weights[j] = 0.0;
+			}
+		}
+	}
+
+	// Held-out complement for the predictive loglikelihood
+	task->complement = task->weights;
+	selector.getComplement(task->complement);
+	if(weightsExclude){
+		for(int j = 0; j < (int)weightsExclude->size(); j++){
+			if(weightsExclude->at(j) == 1.0){
+				task->complement[j] = 0.0;
+			}
+		}
+	}
+}
+
+void GridSearchCrossValidationDriver::buildFold(
+		CyclicCoordinateDescent& ccd,
+		FoldTask* task,
+		bool parallel) {
+
+	task->training = ccd.cloneOnRows(&task->weights[0]);
+	task->heldOut = ccd.cloneOnRows(&task->complement[0], &task->heldOutWeights);
+	if (parallel) {
+		task->training->setNoiseLevel(SILENT); // Report in fold order instead
+		task->training->setThreads(1); // Threads are used across folds instead
+		task->heldOut->setThreads(1);
+	}
+}
+
+void GridSearchCrossValidationDriver::fitFold(
+		FoldTask* task,
+		std::vector<double>* value,
+		const CCDArguments* arguments) {
+
+	task->training->setBeta(startBeta);
+	PathObserver observer = { task->heldOut, &task->heldOutWeights, value,
+			std::vector<double>(task->training->getBetaSize()) };
+	RegularizationPath path(gridSize, lowerLimit, upperLimit);
+	path.fit(*task->training, *arguments, observer);
+}
 
 void GridSearchCrossValidationDriver::findMax(double* maxPoint, double* maxValue) {
 
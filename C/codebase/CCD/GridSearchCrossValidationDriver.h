@@ -9,6 +9,7 @@
 #define CROSSVALIDATIONDRIVER_H_
 
 #include "AbstractCrossValidationDriver.h"
+#include "RegularizationPath.h"
 
 namespace bsccs {
 
@@ -36,6 +37,50 @@ public:
 
 private:
 
+	// One fold's partition and the compact engines over its training and held-out rows
+	struct FoldTask {
+		int index;
+		std::vector<real> weights;
+		std::vector<real> complement;
+		std::vector<real> heldOutWeights;
+		CyclicCoordinateDescent* training;
+		CyclicCoordinateDescent* heldOut;
+	};
+
+	// Records the predictive loglikelihood of one fold at each point on the path, evaluated
+	// on an engine over the held-out rows only
+	struct PathObserver {
+		CyclicCoordinateDescent* heldOut;
+		std::vector<real>* heldOutWeights;
+		std::vector<double>* value;
+		void operator()(int step, double point, CyclicCoordinateDescent& ccd) {
+			for (int j = 0; j < ccd.getBetaSize(); ++j) {
+				beta[j] = ccd.getBeta(j);
+			}
+			heldOut->setBeta(beta);
+			(*value)[step] = heldOut->getPredictiveLogLikelihood(&(*heldOutWeights)[0]);
+		}
+		std::vector<double> beta;
+	};
+
+	void drawFold(
+			AbstractSelector& selector,
+			int i,
+			FoldTask* task,
+			const CCDArguments& arguments);
+
+	void buildFold(
+			CyclicCoordinateDescent& ccd,
+			FoldTask* task,
+			bool parallel);
+
+	void fitFold(
+			FoldTask* task,
+			std::vector<double>* value,
+			const CCDArguments* arguments);
+
+	void reportMax(const CCDArguments& arguments);
+
 	double computeGridPoint(int step);
 
 //	double computePointEstimate(const std::vector<double>& value);
@@ -44,6 +89,7 @@ private:
 
 	std::vector<double> gridPoint;
 	std::vector<double> gridValue;
+	std::vector<double> startBeta;
 
 	int gridSize;
 	double lowerLimit;
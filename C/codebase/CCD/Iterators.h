@@ -2,13 +2,14 @@
 #define ITERATORS_H
 
 #include "CompressedDataMatrix.h"
+#include "SparseIndices.h"
 
 namespace bsccs {
 
 /**
- * Iterators for dense, sparse and indicator vectors.  Each can be passed as a
+ * Iterators for dense, sparse, indicator and bitmap vectors.  Each can be passed as a
  * template parameter to functions for compile-time specialization and optimization.
- * If performance is not an issue, GenericIterator wraps all three formats into a
+ * If performance is not an issue, GenericIterator wraps all formats into a
  * single run-time determined iterator
  */
 
@@ -29,8 +30,8 @@ class IndicatorIterator {
 		// Do nothing
 	}
 
-	inline IndicatorIterator(const std::vector<int>& vec, Index max = 0)
-	: mIndices(vec.data()), mId(0), mEnd(vec.size()) {
+	inline IndicatorIterator(const IndexList& list, Index max = 0)
+	: mIndices(list.indices), mId(0), mEnd(list.size) {
 		// Do nothing
 	}
 
@@ -51,6 +52,131 @@ class IndicatorIterator {
     const Index mEnd;
 };
 
+// Iterator for a bitmap of indicators column; visits the set bits of each word in turn
+class BitmapIterator {
+  public:
+
+	typedef real Scalar;
+	typedef int Index;
+
+	enum  { isIndicator = true };
+	enum  { isSparse = true };
+
+	inline BitmapIterator(const CompressedDataMatrix& mat, Index column)
+	  : mWords(mat.getCompressedColumnVector(column)),
+	    mWord(-1), mBits(0), mEnd(mat.getNumberOfWords(column)) {
+		advance();
+	}
+
+	inline BitmapIterator(const CompressedDataColumn& column)
+	  : mWords(column.getColumns()),
+	    mWord(-1), mBits(0), mEnd(column.getNumberOfWords()) {
+		advance();
+	}
+
+    inline BitmapIterator& operator++() {
+    	mBits &= mBits - 1; // Clear lowest set bit
+    	advance();
+    	return *this;
+    }
+    inline const Scalar value() const { return static_cast<Scalar>(1); }
+
+    inline Index index() const { return mWord * bitmapWordBits + lowestBit(mBits); }
+    inline operator bool() const { return (mWord < mEnd); }
+
+  protected:
+    // Moves to the next non-zero word when the current one is exhausted
+    inline void advance() {
+    	while (mBits == 0 && ++mWord < mEnd) {
+    		mBits = static_cast<unsigned int>(mWords[mWord]);
+    	}
+    }
+
+    const Index* mWords;
+    Index mWord;
+    unsigned int mBits;
+    const Index mEnd;
+};
+
+// Iterator for a delta-packed indicators column; decodes one block of rows at a time
+class PackedIterator {
+  public:
+
+	typedef real Scalar;
+	typedef int Index;
+
+	enum  { isIndicator = true };
+	enum  { isSparse = true };
+
+	inline PackedIterator(const CompressedDataMatrix& mat, Index column)
+	  : mBlock(mat.getCompressedColumnVector(column)) {
+		start();
+	}
+
+	inline PackedIterator(const CompressedDataColumn& column)
+	  : mBlock(column.getColumns()) {
+		start();
+	}
+
+	// NULL words give an empty iterator
+	inline PackedIterator(const Index* words)
+	  : mBlock(words) {
+		start();
+	}
+
+    inline PackedIterator& operator++() {
+    	if (++mId == mEnd) {
+    		nextBlock();
+    	}
+    	return *this;
+    }
+    inline const Scalar value() const { return static_cast<Scalar>(1); }
+
+    inline Index index() const { return mRows[mId]; }
+    inline operator bool() const { return (mId < mEnd); }
+
+  protected:
+    inline void start() {
+    	mRemaining = mBlock ? *mBlock++ : 0;
+    	nextBlock();
+    }
+
+    inline void nextBlock() {
+    	mId = 0;
+    	mEnd = std::min(mRemaining, packedBlockSize);
+    	if (mEnd > 0) {
+    		unpackBlock(mBlock, mEnd, mRows);
+    		mBlock += 2 + getPackedLength(mEnd, mBlock[1]);
+    		mRemaining -= mEnd;
+    	}
+    }
+
+    const Index* mBlock; // Next block to decode
+    Index mRemaining; // Rows in blocks not yet decoded
+    Index mId;
+    Index mEnd;
+    Index mRows[packedBlockSize]; // Current block
+};
+
+/*
+ * Iterator over the SparseIndices list of a column of format IteratorType.  Lists hold
+ * plain indices, so BITMAP and PACKED columns walk their lists as INDICATOR columns do.
+ */
+template <class IteratorType>
+struct IndexListIterator {
+	typedef IteratorType type;
+};
+
+template <>
+struct IndexListIterator<BitmapIterator> {
+	typedef IndicatorIterator type;
+};
+
+template <>
+struct IndexListIterator<PackedIterator> {
+	typedef IndicatorIterator type;
+};
+
 // Iterator for a sparse column
 class SparseIterator {
   public:
@@ -74,8 +200,13 @@ class SparseIterator {
 		// Do nothing
 	}
 
-	inline SparseIterator(const std::vector<int>& vec, Index max = 0)
-	: mIndices(vec.data()), mId(0), mEnd(vec.size()) {
+	inline SparseIterator(const IndexList& list, Index max = 0)
+	: mIndices(list.indices), mId(0), mEnd(list.size) {
+		// Do nothing
+	}
+
+	inline SparseIterator(const std::vector<int>& indices, const std::vector<Scalar>& values)
+	: mValues(values.data()), mIndices(indices.data()), mId(0), mEnd(indices.size()) {
 		// Do nothing
 	}
 
@@ -141,7 +272,7 @@ class DenseIterator {
 		// Do nothing
 	}
 
-	inline DenseIterator(const std::vector<int>& vec, Index end)
+	inline DenseIterator(const IndexList& list, Index end)
 	: mId(0), mEnd(end) {
 		// Do nothing
 	}
@@ -180,7 +311,7 @@ class InterceptIterator {
 		// Do nothing
 	}
 
-	inline InterceptIterator(const std::vector<int>& vec, Index end)
+	inline InterceptIterator(const IndexList& list, Index end)
 	: mId(0), mEnd(end) {
 		// Do nothing
 	}
@@ -238,11 +369,22 @@ class GenericIterator {
 
 	inline GenericIterator(const CompressedDataMatrix& mat, Index column)
 	  : mFormatType(mat.getFormatType(column)),
-	    mId(0) {
+	    mId(0), mBits(0),
+	    mPacked(mFormatType == PACKED ? mat.getCompressedColumnVector(column) : NULL) {
 		if (mFormatType == DENSE) {
 			mValues = mat.getDataVector(column);
 			mIndices = NULL;
 			mEnd = mat.getNumberOfRows();
+		} else if (mFormatType == BITMAP) {
+			mValues = NULL;
+			mIndices = mat.getCompressedColumnVector(column);
+			mEnd = mat.getNumberOfWords(column);
+			mId = -1;
+			advanceBitmap();
+		} else if (mFormatType == PACKED) {
+			mValues = NULL;
+			mIndices = NULL;
+			mEnd = 0; // Iterates through mPacked
 		} else {
 			if (mFormatType == SPARSE) {
 				mValues = mat.getDataVector(column);
@@ -254,10 +396,20 @@ class GenericIterator {
 		}		
 	}
 
-    inline GenericIterator& operator++() { ++mId; return *this; }
+    inline GenericIterator& operator++() {
+    	if (mFormatType == BITMAP) {
+    		mBits &= mBits - 1;
+    		advanceBitmap();
+    	} else if (mFormatType == PACKED) {
+    		++mPacked;
+    	} else {
+    		++mId;
+    	}
+    	return *this;
+    }
 
     inline const Scalar value() const {
-    	if (mFormatType == INDICATOR) {
+    	if (mFormatType == INDICATOR || mFormatType == BITMAP || mFormatType == PACKED) {
     		return static_cast<Scalar>(1);
     	} else {
     		return mValues[mId];
@@ -268,18 +420,33 @@ class GenericIterator {
     inline Index index() const {
     	if (mFormatType == DENSE) {
     		return mId;
+    	} else if (mFormatType == BITMAP) {
+    		return mId * bitmapWordBits + lowestBit(mBits);
+    	} else if (mFormatType == PACKED) {
+    		return mPacked.index();
     	} else {
     		return mIndices[mId];
     	}
     }
-    inline operator bool() const { return (mId < mEnd); }
+    inline operator bool() const {
+    	return (mFormatType == PACKED) ? static_cast<bool>(mPacked) : (mId < mEnd);
+    }
 
   protected:
+    // For BITMAP, mId is the current word and mBits its unvisited set bits
+    inline void advanceBitmap() {
+    	while (mBits == 0 && ++mId < mEnd) {
+    		mBits = static_cast<unsigned int>(mIndices[mId]);
+    	}
+    }
+
     const FormatType mFormatType;
     Scalar* mValues;
     Index* mIndices;
     Index mId;
+    unsigned int mBits;
     Index mEnd;
+    PackedIterator mPacked;
 };
 
 // Iterator for the component-wise product of two Iterator
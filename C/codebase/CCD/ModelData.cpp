@@ -14,8 +14,12 @@
 #include <cstring>
 #include <algorithm>
 #include <numeric>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
 
 #include "ModelData.h"
+#include "Iterators.h"
 
 namespace bsccs {
 
@@ -93,6 +97,173 @@ int ModelData::getNumberOfVariableColumns() const {
 	return dim;
 }
 
+ModelData* ModelData::getRowSubset(const std::vector<int>& rows) const {
+	ModelData* subset = new ModelData();
+	const int nSubsetRows = rows.size();
+
+	std::vector<int> newRow(getNumberOfRows(), -1);
+	for (int i = 0; i < nSubsetRows; ++i) {
+		const int k = rows[i];
+		newRow[k] = i;
+		if (i == 0 || pid[k] != pid[rows[i - 1]]) {
+			++subset->nPatients;
+		}
+		subset->pid.push_back(pid[k]);
+		subset->y.push_back(y[k]);
+		if (!z.empty()) {
+			subset->z.push_back(z[k]);
+		}
+		if (!offs.empty()) {
+			subset->offs.push_back(offs[k]);
+		}
+		if (getHasRowLobels()) {
+			subset->labels.push_back(labels[k]);
+		}
+		if (!fixedTermCorrections.empty()) {
+			subset->fixedTermCorrections.push_back(fixedTermCorrections[k]);
+		}
+	}
+	subset->nRows = nSubsetRows;
+	subset->conditionId = conditionId;
+	subset->hasOffsetCovariate = hasOffsetCovariate;
+	subset->hasInterceptCovariate = hasInterceptCovariate;
+	subset->rowMajorBudget = rowMajorBudget;
+	subset->bitmapDensity = bitmapDensity;
+	subset->packIndices = packIndices;
+
+	for (int j = 0; j < getNumberOfColumns(); ++j) {
+		const CompressedDataColumn& column = getColumn(j);
+		const FormatType format = column.getFormatType();
+		int_vector* indices = NULL;
+		real_vector* values = NULL;
+		if (format == DENSE) {
+			const real* data = column.getData();
+			values = new real_vector(nSubsetRows);
+			for (int i = 0; i < nSubsetRows; ++i) {
+				(*values)[i] = data[rows[i]];
+			}
+		} else if (format == SPARSE || format == INDICATOR) {
+			const int* columns = column.getColumns();
+			const real* data = (format == SPARSE) ? column.getData() : NULL;
+			indices = new int_vector();
+			indices->reserve(column.getNumberOfEntries());
+			if (data) {
+				values = new real_vector();
+				values->reserve(column.getNumberOfEntries());
+			}
+			for (int n = 0; n < column.getNumberOfEntries(); ++n) {
+				const int i = newRow[columns[n]];
+				if (i >= 0) {
+					indices->push_back(i);
+					if (data) {
+						values->push_back(data[n]);
+					}
+				}
+			}
+		} else if (format == BITMAP) {
+			// Filtered rows as an INDICATOR column; finalize() decides whether to repack it
+			indices = new int_vector();
+			for (BitmapIterator it(column); it; ++it) {
+				const int i = newRow[it.index()];
+				if (i >= 0) {
+					indices->push_back(i);
+				}
+			}
+		} else if (format == PACKED) {
+			indices = new int_vector();
+			for (PackedIterator it(column); it; ++it) {
+				const int i = newRow[it.index()];
+				if (i >= 0) {
+					indices->push_back(i);
+				}
+			}
+		}
+		subset->push_back(indices, values,
+				(format == BITMAP || format == PACKED) ? INDICATOR : format);
+		subset->getColumn(j).add_label(column.getNumericalLabel());
+	}
+	subset->finalize();
+	return subset;
+}
+
+ModelData* ModelData::getCollapsedRows(int threads) const {
+	std::shared_ptr<const CompressedDataRows> rows = getRows(threads);
+	if (!rows) {
+		return NULL;
+	}
+	const int K = getNumberOfRows();
+
+	// Group identical rows by hash within each stratum run; first occurrences represent them
+	std::vector<int> representatives;
+	std::vector<int> mergedInto(K);
+	std::unordered_map<size_t, std::vector<int> > seen;
+	for (int k = 0; k < K; ++k) {
+		if (k == 0 || pid[k] != pid[k - 1]) {
+			seen.clear();
+		}
+		const size_t begin = rows->rowPointers[k];
+		const size_t end = rows->rowPointers[k + 1];
+		size_t hash = end - begin;
+		for (size_t i = begin; i < end; ++i) {
+			hash = hash * 31 + std::hash<int>()(rows->columns[i]);
+			hash = hash * 31 + std::hash<real>()(rows->values[i]);
+		}
+
+		std::vector<int>& candidates = seen[hash];
+		int match = -1;
+		for (std::vector<int>::const_iterator it = candidates.begin();
+				it != candidates.end() && match < 0; ++it) {
+			const size_t other = rows->rowPointers[*it];
+			if (rows->rowPointers[*it + 1] - other == end - begin
+					&& std::equal(rows->columns.begin() + begin, rows->columns.begin() + end,
+							rows->columns.begin() + other)
+					&& std::equal(rows->values.begin() + begin, rows->values.begin() + end,
+							rows->values.begin() + other)) {
+				match = *it;
+			}
+		}
+		if (match < 0) {
+			candidates.push_back(k);
+			mergedInto[k] = representatives.size();
+			representatives.push_back(k);
+		} else {
+			mergedInto[k] = mergedInto[match];
+		}
+	}
+	if (static_cast<int>(representatives.size()) == K) {
+		return NULL;
+	}
+
+	ModelData* collapsed = getRowSubset(representatives);
+	const int nCollapsed = representatives.size();
+	std::vector<real> sumY(nCollapsed, static_cast<real>(0));
+	std::vector<real> sumOffs(nCollapsed, static_cast<real>(0));
+	std::vector<double> sumFixedTerms(nCollapsed, 0.0);
+	for (int k = 0; k < K; ++k) {
+		const int i = mergedInto[k];
+		sumY[i] += y[k];
+		if (!offs.empty()) {
+			sumOffs[i] += offs[k];
+			sumFixedTerms[i] += (y[k] != 0) ? y[k] * std::log(offs[k]) : 0.0;
+		}
+	}
+	collapsed->y = sumY;
+	if (!offs.empty()) {
+		collapsed->offs = sumOffs;
+		collapsed->fixedTermCorrections.resize(nCollapsed);
+		for (int i = 0; i < nCollapsed; ++i) {
+			const double merged = (sumY[i] != 0) ? sumY[i] * std::log(sumOffs[i]) : 0.0;
+			collapsed->fixedTermCorrections[i] = static_cast<real>(sumFixedTerms[i] - merged);
+		}
+		if (!fixedTermCorrections.empty()) { // Carry corrections of an earlier collapse
+			for (int k = 0; k < K; ++k) {
+				collapsed->fixedTermCorrections[mergedInto[k]] += fixedTermCorrections[k];
+			}
+		}
+	}
+	return collapsed;
+}
+
 const string ModelData::missing = "NA";
 
 } // namespace
@@ -99,6 +99,26 @@ public:
 
 	int getNumberOfVariableColumns() const;
 
+	/**
+	 * Copy holding only the given rows, which must be increasing.  Rows are renumbered from 0
+	 * and every column keeps just its entries in those rows.
+	 */
+	ModelData* getRowSubset(const std::vector<int>& rows) const;
+
+	/**
+	 * Copy in which rows of one stratum with identical covariates are merged into their first
+	 * row, summing outcomes and offsets.  This leaves the self-controlled case series
+	 * likelihood unchanged up to its y * log(offset) terms, which are kept exact through
+	 * getFixedTermCorrections().  NULL when no rows merge or the row-major copy of X used to
+	 * compare rows exceeds its budget.
+	 */
+	ModelData* getCollapsedRows(int threads) const;
+
+	// Per-row additions to the fixed log-likelihood terms; empty unless rows were collapsed
+	const std::vector<real>& getFixedTermCorrections() const {
+		return fixedTermCorrections;
+	}
+
 	const string& getRowLabel(size_t i) const {
 		if (i >= labels.size()) {
 			return missing;
@@ -114,6 +134,8 @@ public:
 	friend class CoxInputReader;
 	friend class CCTestInputReader;
 	friend class GenericSparseReader;
+	friend class BinaryInputReader;
+	friend class BinaryOutputWriter;
 
 	template <class FormatType, class MissingPolicy> friend class BaseInputReader;
 	template <class ImputationPolicy> friend class BBRInputReader;
@@ -134,6 +156,7 @@ private:
 	bool hasOffsetCovariate;
 	bool hasInterceptCovariate;
 	vector<string> labels;
+	vector<real> fixedTermCorrections;
 	static const string missing;
 };
 
@@ -13,6 +13,7 @@
 #include <iostream>
 
 #include "AbstractModelSpecifics.h"
+#include "kernels/SimdKernels.h"
 
 namespace bsccs {
 
@@ -28,11 +29,25 @@ public:
 	void computeGradientAndHessian(int index, double *ogradient,
 			double *ohessian,  bool useWeights);
 
+	AbstractModelSpecifics* clone() const;
+
+	AbstractModelSpecifics* clone(const ModelData& data) const;
+
+	// Entry points for StaticCyclicCoordinateDescent, with the column format and use of
+	// weights fixed at compile time; each combines the numerator and gradient passes
+	template <class IteratorType, bool Weighted>
+	void computeGradientAndHessianForColumn(int index, double *ogradient, double *ohessian);
+
+	template <class IteratorType>
+	void updateXBetaForColumn(real delta, int index, bool useWeights);
+
 protected:
 	void computeNumeratorForGradient(int index);
 
 	void computeFisherInformation(int indexOne, int indexTwo, double *oinfo, bool useWeights);
 
+	bool getFisherInformationGroups(int index, std::vector<int>* groups);
+
 	void updateXBeta(real realDelta, int index, bool useWeights);
 
 	void computeRemainingStatistics(bool useWeights);
@@ -53,6 +68,8 @@ protected:
 
 	bool allocateXjX(void);
 
+	bool allocateSparseIndices(void);
+
 	bool sortPid(void);
 
 	void setWeights(real* inWeights, bool useCrossValidation);
@@ -66,12 +83,54 @@ private:
 			double *gradient,
 			double *hessian, Weights w);
 
+	template <class IteratorType, class Weights>
+	void computeCumulativeGradientAndHessianImpl(
+			int index,
+			real *gradient,
+			real *hessian, Weights w);
+
+	void computePrefixSums();
+
+	real getAccDenom(int i) {
+		const int stream = (accDenomUseWeights && hKWeight[i] != static_cast<WeightType>(1)) ? 1 : 0;
+		return accDenomPid[i] + accDenomOffset[2 * (i / accDenomBlockSize) + stream];
+	}
+
+	void markAccDenomDirty(int i);
+
+	void scanAccDenomBlocks(const std::vector<int>* blocks, int first, int last);
+
+	template <class IteratorType>
+	void computeNumeratorForGradientImpl(int index);
+
 	template <class IteratorType>
 	void incrementNumeratorForGradientImpl(int index);
 
+	// Segmented reductions over the contiguous row runs of strata [first, last)
+	void computeDenominatorsForStrata(int first, int last);
+
+	template <class IteratorType>
+	void incrementNumeratorForStrata(int index, int first, int last);
+
+	void buildStrataOffsets(void);
+
+	// Runs (this->*method)(args..., first, last) over blocks of strata holding similar numbers
+	// of rows, one block per thread
+	template <typename Method, typename... Args>
+	void forStrataBlocks(Method method, Args... args);
+
 	template <class IteratorType>
 	void updateXBetaImpl(real delta, int index, bool useWeights);
 
+	bool isVectorized(int index);
+
+	const real* getVectorizedColumn(int index);
+
+	void updateXBetaVectorized(real delta, int index, bool useWeights);
+
+	void computeGradientAndHessianVectorized(int index, double *ogradient,
+			double *ohessian, bool useWeights);
+
 	template <class OutType, class InType>
 	void incrementByGroup(OutType* values, int* groups, int k, InType inc) {
 		values[BaseModel::getGroup(groups, k)] += inc;
@@ -83,19 +142,73 @@ private:
 	template <class IteratorTypeOne, class IteratorTypeTwo, class Weights>
 	void computeFisherInformationImpl(int indexOne, int indexTwo, double *oinfo, Weights w);
 
+	// Per-stratum cross-terms of covariate index, from the cache or computed and inserted
 	template<class IteratorType>
-	SparseIterator getSubjectSpecificHessianIterator(int index);
+	CrossTermCache::EntryPtr getSubjectSpecificHessianTerms(int index);
+
+	template <class IteratorType>
+	void getFisherInformationGroupsImpl(int index, std::vector<int>* groups);
 
 	void computeXjY(bool useCrossValidation);
 
 	void computeXjX(bool useCrossValidation);
 
+	void refreshLogLikelihood(bool useCrossValidation);
+
+	void refreshLogLikelihoodDenominator();
+
 	std::vector<WeightType> hNWeight;
 	std::vector<WeightType> hKWeight;
 
 	std::vector<int> nPid;
 	std::vector<real> nY;
 
+	// Log-likelihood terms kept up-to-date in updateXBeta; only touched strata are
+	// re-evaluated (all of them after a dense or intercept update) and a full refresh every
+	// logLikelihoodRefreshInterval calls bounds drift
+	const static int logLikelihoodRefreshInterval = 10;
+	bool logLikelihoodKnown;
+	bool denomAllDirty;
+	int logLikelihoodEvaluations;
+	double logLikelihoodNumerator;
+	double logLikelihoodDenominator;
+	std::vector<double> denomContrib;
+	std::vector<char> denomDirty;
+	std::vector<int> dirtyStrata;
+
+	// Stratum i spans rows [strataOffsets[i], strataOffsets[i + 1]), since init() renumbers
+	// pids into sorted, contiguous runs; empty for models whose rows are their own strata
+	std::vector<int> strataOffsets;
+
+	// Indicator and intercept updates scale offsExpXBeta by exp(delta) instead of taking an
+	// exp per row; each row is recomputed from hXBeta after offsExpXBetaRefreshInterval
+	// consecutive scalings to bound drift
+	const static int offsExpXBetaRefreshInterval = 16;
+	std::vector<unsigned char> offsExpXBetaScalings;
+
+	// Prefix sums over risk-set ordered rows of nEvents / accDenom and nEvents / accDenom^2;
+	// shared by all sparse columns.  Entries 0..prefixSumsValidRows are current; an update
+	// invalidates only those from its first changed row onward
+	int prefixSumsValidRows;
+	std::vector<double> prefixInvDenom;
+	std::vector<double> prefixInvDenom2;
+
+	// Two-level prefix scan for the Cox risk sets: accDenomPid holds sums within each block of
+	// accDenomBlockSize rows and accDenomOffset the sum over all earlier blocks.  Training and
+	// held-out rows form separate streams (entries 2b and 2b + 1) when using weights.  After an
+	// update only the touched blocks and the block offsets are rescanned.
+	int accDenomBlockSize;
+	int accDenomBlocks;
+	bool accDenomUseWeights;
+	bool accDenomAllDirty;
+	std::vector<real> accDenomTotal;
+	std::vector<real> accDenomOffset;
+	std::vector<char> accDenomBlockDirty;
+	std::vector<int> accDenomDirtyBlocks;
+
+	// Vectorized loops for DENSE and INTERCEPT columns; NULL when the model or CPU has none
+	const SimdKernels<real>* simdKernels;
+
 	struct WeightedOperation {
 		const static bool isWeighted = true;
 	} weighted;
@@ -134,24 +247,46 @@ struct GroupedData {
 public:
 	const static bool hasStrataCrossTerms = true;
 
+	const static bool hasIndependentRows = false;
+
 	int getGroup(int* groups, int k) {
 		return groups[k];
 	}
+
+	void denseGradientAndHessian(const SimdKernels<real>& kernels, int n, const real* x,
+			const real* offsExpXBeta, const real* xBeta, const real* y, const real* denom,
+			const real* weights, real* gradient, real* hessian) {
+		std::cerr << "Error!" << std::endl;
+		exit(-1);
+	}
 };
 
 struct OrderedData {
 public:
 	const static bool hasStrataCrossTerms = true;
 
+	const static bool hasIndependentRows = false;
+
 	int getGroup(int* groups, int k) {
 		return groups[k];
 	}
+
+	void denseGradientAndHessian(const SimdKernels<real>& kernels, int n, const real* x,
+			const real* offsExpXBeta, const real* xBeta, const real* y, const real* denom,
+			const real* weights, real* gradient, real* hessian) {
+		std::cerr << "Error!" << std::endl;
+		exit(-1);
+	}
 };
 
 struct IndependentData {
 public:
 	const static bool hasStrataCrossTerms = false;
 
+	// Rows are their own strata, so dense columns are vectorized and numerators are formed
+	// per row inside computeGradientAndHessian, without numerPid
+	const static bool hasIndependentRows = true;
+
 	int getGroup(int* groups, int k) {
 		return k;
 	}
@@ -266,6 +401,13 @@ public:
 			}
 		}
 	}
+
+	// For an intercept numer2 == numer, so the Hessian term reduces to g * (1 - g)
+	void denseGradientAndHessian(const SimdKernels<real>& kernels, int n, const real* x,
+			const real* offsExpXBeta, const real* xBeta, const real* y, const real* denom,
+			const WeightType* weights, real* gradient, real* hessian) {
+		kernels.logisticGradientAndHessian(n, x, offsExpXBeta, denom, weights, gradient, hessian);
+	}
 };
 
 template <typename WeightType>
@@ -580,6 +722,12 @@ public:
 		return static_cast<real>(0);
 	}
 
+	void denseGradientAndHessian(const SimdKernels<real>& kernels, int n, const real* x,
+			const real* offsExpXBeta, const real* xBeta, const real* y, const real* denom,
+			const WeightType* weights, real* gradient, real* hessian) {
+		kernels.leastSquaresGradientAndHessian(n, x, xBeta, y, weights, gradient, hessian);
+	}
+
 	template <class IteratorType, class Weights>
 	void incrementFisherInformation(
 			const IteratorType& it,
@@ -690,6 +838,12 @@ public:
 			}
 	}
 
+	void denseGradientAndHessian(const SimdKernels<real>& kernels, int n, const real* x,
+			const real* offsExpXBeta, const real* xBeta, const real* y, const real* denom,
+			const WeightType* weights, real* gradient, real* hessian) {
+		kernels.poissonGradientAndHessian(n, x, offsExpXBeta, denom, weights, gradient, hessian);
+	}
+
 	real getOffsExpXBeta(real* offs, real xBeta, real y, int k) {
 		return std::exp(xBeta);
 	}
@@ -12,8 +12,10 @@
 #include <cstdlib>
 #include <algorithm>
 #include <numeric>
+#include <thread>
 
 #include "ModelSpecifics.h"
+#include "ModelData.h"
 #include "Iterators.h"
 
 namespace bsccs {
@@ -27,7 +29,10 @@ namespace bsccs {
 
 template <class BaseModel,typename WeightType>
 ModelSpecifics<BaseModel,WeightType>::ModelSpecifics(const ModelData& input)
-	: AbstractModelSpecifics(input), BaseModel() {
+	: AbstractModelSpecifics(input), BaseModel(), logLikelihoodKnown(false), denomAllDirty(false),
+	  logLikelihoodEvaluations(0), prefixSumsValidRows(0), accDenomBlockSize(1),
+	  accDenomBlocks(0), accDenomUseWeights(false), accDenomAllDirty(true),
+	  simdKernels(BaseModel::hasIndependentRows ? SimdKernels<real>::get() : NULL) {
 	// TODO Memory allocation here
 }
 
@@ -36,12 +41,28 @@ ModelSpecifics<BaseModel,WeightType>::~ModelSpecifics() {
 	// TODO Memory release here
 }
 
+template <class BaseModel,typename WeightType>
+AbstractModelSpecifics* ModelSpecifics<BaseModel,WeightType>::clone() const {
+	return clone(modelData);
+}
+
+template <class BaseModel,typename WeightType>
+AbstractModelSpecifics* ModelSpecifics<BaseModel,WeightType>::clone(const ModelData& data) const {
+	ModelSpecifics<BaseModel,WeightType>* copy = new ModelSpecifics<BaseModel,WeightType>(data);
+	copy->setCrossTermCacheBudget(hessianCrossTermCache.getBudget());
+	copy->setThreads(nThreads);
+	return copy;
+}
+
 template <class BaseModel,typename WeightType>
 bool ModelSpecifics<BaseModel,WeightType>::allocateXjY(void) { return BaseModel::precomputeGradient; }
 
 template <class BaseModel,typename WeightType>
 bool ModelSpecifics<BaseModel,WeightType>::allocateXjX(void) { return BaseModel::precomputeHessian; }
 
+template <class BaseModel,typename WeightType>
+bool ModelSpecifics<BaseModel,WeightType>::allocateSparseIndices(void) { return !BaseModel::hasIndependentRows; }
+
 template <class BaseModel,typename WeightType>
 bool ModelSpecifics<BaseModel,WeightType>::sortPid(void) { return BaseModel::sortPid; }
 
@@ -58,14 +79,27 @@ void ModelSpecifics<BaseModel,WeightType>::setWeights(real* inWeights, bool useC
 	} else {
 		std::fill(hKWeight.begin(), hKWeight.end(), static_cast<WeightType>(1));
 	}
+	logLikelihoodKnown = false;
+	prefixSumsValidRows = 0;
+	accDenomAllDirty = true;
+
 	// Set N weights (these are the same for independent data models
 	if (hNWeight.size() != N) {
 		hNWeight.resize(N);
 	}
-	std::fill(hNWeight.begin(), hNWeight.end(), static_cast<WeightType>(0));
-	for (int k = 0; k < K; ++k) {
-		WeightType event = BaseModel::observationCount(hY[k])*hKWeight[k];
-		incrementByGroup(hNWeight.data(), hPid, k, event);
+	if (BaseModel::hasIndependentRows) { // Compile-time switch
+		for (int k = 0; k < K; ++k) {
+			hNWeight[k] = BaseModel::observationCount(hY[k])*hKWeight[k];
+		}
+	} else {
+		buildStrataOffsets();
+		for (int i = 0; i < N; ++i) {
+			WeightType events = static_cast<WeightType>(0);
+			for (int k = strataOffsets[i]; k < strataOffsets[i + 1]; ++k) {
+				events += BaseModel::observationCount(hY[k])*hKWeight[k];
+			}
+			hNWeight[i] = events;
+		}
 	}
 }
 
@@ -115,6 +149,7 @@ void ModelSpecifics<BaseModel, WeightType>::computeXjX(bool useCrossValidation)
 
 template <class BaseModel,typename WeightType>
 void ModelSpecifics<BaseModel,WeightType>::computeFixedTermsInLogLikelihood(bool useCrossValidation) {
+	logLikelihoodKnown = false;
 	if(BaseModel::likelihoodHasFixedTerms) {
 		logLikelihoodFixedTerm = 0.0;
 		if(useCrossValidation) {
@@ -126,6 +161,14 @@ void ModelSpecifics<BaseModel,WeightType>::computeFixedTermsInLogLikelihood(bool
 				logLikelihoodFixedTerm += BaseModel::logLikeFixedTermsContrib(hY[i], hOffs[i]);
 			}
 		}
+		// Terms of rows merged by ModelData::getCollapsedRows()
+		const std::vector<real>& corrections = modelData.getFixedTermCorrections();
+		if (!corrections.empty()) {
+			for (int i = 0; i < K; i++) {
+				logLikelihoodFixedTerm += useCrossValidation ?
+						corrections[i] * hKWeight[i] : corrections[i];
+			}
+		}
 	}
 }
 
@@ -143,38 +186,84 @@ void ModelSpecifics<BaseModel,WeightType>::computeFixedTermsInGradientAndHessian
 }
 
 template <class BaseModel,typename WeightType>
-double ModelSpecifics<BaseModel,WeightType>::getLogLikelihood(bool useCrossValidation) {
+void ModelSpecifics<BaseModel,WeightType>::refreshLogLikelihood(bool useCrossValidation) {
 
-	real logLikelihood = static_cast<real>(0.0);
+	double numerator = 0.0;
 	if (useCrossValidation) {
 		for (int i = 0; i < K; i++) {
-			logLikelihood += BaseModel::logLikeNumeratorContrib(hY[i], hXBeta[i]) * hKWeight[i];
+			numerator += BaseModel::logLikeNumeratorContrib(hY[i], hXBeta[i]) * hKWeight[i];
 		}
 	} else {
 		for (int i = 0; i < K; i++) {
-			logLikelihood += BaseModel::logLikeNumeratorContrib(hY[i], hXBeta[i]);
+			numerator += BaseModel::logLikeNumeratorContrib(hY[i], hXBeta[i]);
 		}
 	}
+	logLikelihoodNumerator = numerator;
 
+	logLikelihoodDenominator = 0.0;
 	if (BaseModel::likelihoodHasDenominator) { // Compile-time switch
-		if(BaseModel::cumulativeGradientAndHessian) {
-			for (int i = 0; i < N; i++) {
-				// Weights modified in computeNEvents()
-				logLikelihood -= BaseModel::logLikeDenominatorContrib(hNWeight[i], accDenomPid[i]);
-			}
-		} else {  // TODO Unnecessary code duplication
-			for (int i = 0; i < N; i++) {
-				// Weights modified in computeNEvents()
-				logLikelihood -= BaseModel::logLikeDenominatorContrib(hNWeight[i], denomPid[i]);
+		refreshLogLikelihoodDenominator();
+	}
+
+	logLikelihoodKnown = true;
+	logLikelihoodEvaluations = 0;
+}
+
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::refreshLogLikelihoodDenominator() {
+
+	double denominator = 0.0;
+	if(BaseModel::cumulativeGradientAndHessian) {
+		for (int i = 0; i < N; i++) {
+			// Weights modified in computeNEvents()
+			denominator += BaseModel::logLikeDenominatorContrib(hNWeight[i], getAccDenom(i));
+		}
+	} else {
+		if (static_cast<int>(denomContrib.size()) != N) {
+			denomContrib.resize(N);
+			denomDirty.resize(N);
+		}
+		for (int i = 0; i < N; i++) {
+			// Weights modified in computeNEvents()
+			denomContrib[i] = BaseModel::logLikeDenominatorContrib(hNWeight[i], denomPid[i]);
+			denominator += denomContrib[i];
+		}
+		std::fill(denomDirty.begin(), denomDirty.end(), 0);
+		dirtyStrata.clear();
+		denomAllDirty = false;
+	}
+	logLikelihoodDenominator = denominator;
+}
+
+template <class BaseModel,typename WeightType>
+double ModelSpecifics<BaseModel,WeightType>::getLogLikelihood(bool useCrossValidation) {
+
+	if (!logLikelihoodKnown || ++logLikelihoodEvaluations >= logLikelihoodRefreshInterval) {
+		refreshLogLikelihood(useCrossValidation);
+	} else if (BaseModel::likelihoodHasDenominator) { // Compile-time switch
+		if (BaseModel::cumulativeGradientAndHessian || denomAllDirty) {
+			// Every accumulated denominator after a touched row has changed, or every row has
+			refreshLogLikelihoodDenominator();
+		} else {
+			for (std::vector<int>::const_iterator it = dirtyStrata.begin();
+					it != dirtyStrata.end(); ++it) {
+				const int i = *it;
+				const double contrib = BaseModel::logLikeDenominatorContrib(hNWeight[i], denomPid[i]);
+				logLikelihoodDenominator += contrib - denomContrib[i];
+				denomContrib[i] = contrib;
+				denomDirty[i] = 0;
 			}
+			dirtyStrata.clear();
 		}
 	}
 
+	double logLikelihood = logLikelihoodNumerator - logLikelihoodDenominator;
+
 	if (BaseModel::likelihoodHasFixedTerms) {
 		logLikelihood += logLikelihoodFixedTerm;
 	}
 
-	return static_cast<double>(logLikelihood);
+	return logLikelihood;
 }
 
 template <class BaseModel,typename WeightType>
@@ -182,8 +271,12 @@ double ModelSpecifics<BaseModel,WeightType>::getPredictiveLogLikelihood(real* we
 	real logLikelihood = static_cast<real>(0.0);
 
 	if(BaseModel::cumulativeGradientAndHessian)	{
+		std::vector<real> accDenom(K);
 		for (int k = 0; k < K; ++k) {
-			logLikelihood += BaseModel::logPredLikeContrib(hY[k], weights[k], hXBeta[k], &accDenomPid[0], hPid, k);
+			accDenom[k] = getAccDenom(k);
+		}
+		for (int k = 0; k < K; ++k) {
+			logLikelihood += BaseModel::logPredLikeContrib(hY[k], weights[k], hXBeta[k], &accDenom[0], hPid, k);
 		}
 	} else { // TODO Unnecessary code duplication
 		for (int k = 0; k < K; ++k) {
@@ -224,12 +317,22 @@ void ModelSpecifics<BaseModel,WeightType>::getPredictiveEstimates(real* y, real*
 template <class BaseModel,typename WeightType>
 void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessian(int index, double *ogradient,
 		double *ohessian, bool useWeights) {
+	if (isVectorized(index)) {
+		computeGradientAndHessianVectorized(index, ogradient, ohessian, useWeights);
+		return;
+	}
 	// Run-time dispatch, so virtual call should not effect speed
 	if (useWeights) {
 		switch (hXI->getFormatType(index)) {
 			case INDICATOR :
 				computeGradientAndHessianImpl<IndicatorIterator>(index, ogradient, ohessian, weighted);
 				break;
+			case BITMAP :
+				computeGradientAndHessianImpl<BitmapIterator>(index, ogradient, ohessian, weighted);
+				break;
+			case PACKED :
+				computeGradientAndHessianImpl<PackedIterator>(index, ogradient, ohessian, weighted);
+				break;
 			case SPARSE :
 				computeGradientAndHessianImpl<SparseIterator>(index, ogradient, ohessian, weighted);
 				break;
@@ -245,6 +348,12 @@ void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessian(int index,
 			case INDICATOR :
 				computeGradientAndHessianImpl<IndicatorIterator>(index, ogradient, ohessian, unweighted);
 				break;
+			case BITMAP :
+				computeGradientAndHessianImpl<BitmapIterator>(index, ogradient, ohessian, unweighted);
+				break;
+			case PACKED :
+				computeGradientAndHessianImpl<PackedIterator>(index, ogradient, ohessian, unweighted);
+				break;
 			case SPARSE :
 				computeGradientAndHessianImpl<SparseIterator>(index, ogradient, ohessian, unweighted);
 				break;
@@ -266,9 +375,11 @@ void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessianImpl(int ind
 	real gradient = static_cast<real>(0);
 	real hessian = static_cast<real>(0);
 
-	IteratorType it(*(*sparseIndices)[index], N); // TODO How to create with different constructor signatures?
+	typename IndexListIterator<IteratorType>::type it((*sparseIndices)[index], N); // TODO How to create with different constructor signatures?
 
-	if (BaseModel::cumulativeGradientAndHessian) { // Compile-time switch
+	if (BaseModel::cumulativeGradientAndHessian && IteratorType::isSparse) { // Compile-time switch
+		computeCumulativeGradientAndHessianImpl<IteratorType>(index, &gradient, &hessian, w);
+	} else if (BaseModel::cumulativeGradientAndHessian) { // Compile-time switch
 		
 		real accNumerPid  = static_cast<real>(0);
 		real accNumerPid2 = static_cast<real>(0);
@@ -289,13 +400,13 @@ void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessianImpl(int ind
 			}
 #ifdef DEBUG_COX
 			cerr << "w: " << k << " " << hNWeight[k] << " " << numerPid[BaseModel::getGroup(hPid, k)] << ":" <<
-					accNumerPid << ":" << accNumerPid2 << ":" << accDenomPid[BaseModel::getGroup(hPid, k)];
+					accNumerPid << ":" << accNumerPid2 << ":" << getAccDenom(BaseModel::getGroup(hPid, k));
 #endif			
 			// Compile-time delegation
 			BaseModel::incrementGradientAndHessian(it,
 					w, // Signature-only, for iterator-type specialization
 					&gradient, &hessian, accNumerPid, accNumerPid2,
-					accDenomPid[BaseModel::getGroup(hPid, k)], hNWeight[k], it.value(), hXBeta[k], hY[k]); // When function is in-lined, compiler will only use necessary arguments
+					getAccDenom(BaseModel::getGroup(hPid, k)), hNWeight[k], it.value(), hXBeta[k], hY[k]); // When function is in-lined, compiler will only use necessary arguments
 #ifdef DEBUG_COX		
 			cerr << " -> g:" << gradient << " h:" << hessian << endl;	
 #endif
@@ -306,13 +417,13 @@ void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessianImpl(int ind
 				for (++k; k < next; ++k) {
 #ifdef DEBUG_COX
 			cerr << "q: " << k << " " << hNWeight[k] << " " << 0 << ":" <<
-					accNumerPid << ":" << accNumerPid2 << ":" << accDenomPid[BaseModel::getGroup(hPid, k)];
+					accNumerPid << ":" << accNumerPid2 << ":" << getAccDenom(BaseModel::getGroup(hPid, k));
 #endif			
 					
 					BaseModel::incrementGradientAndHessian(it,
 							w, // Signature-only, for iterator-type specialization
 							&gradient, &hessian, accNumerPid, accNumerPid2,
-							accDenomPid[BaseModel::getGroup(hPid, k)], hNWeight[k], static_cast<real>(0), hXBeta[k], hY[k]); // When function is in-lined, compiler will only use necessary arguments
+							getAccDenom(BaseModel::getGroup(hPid, k)), hNWeight[k], static_cast<real>(0), hXBeta[k], hY[k]); // When function is in-lined, compiler will only use necessary arguments
 #ifdef DEBUG_COX		
 			cerr << " -> g:" << gradient << " h:" << hessian << endl;	
 #endif
@@ -321,6 +432,22 @@ void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessianImpl(int ind
 			}
 		}
 		//exit(-1);	
+	} else if (BaseModel::hasIndependentRows) { // Compile-time switch
+		// Single pass over the column values; each row is its own group
+		IteratorType itValues(*hXI, index);
+		for (; itValues; ++itValues) {
+			const int k = itValues.index();
+			const real numer = BaseModel::gradientNumeratorContrib(itValues.value(),
+					offsExpXBeta[k], hXBeta[k], hY[k]);
+			const real numer2 = (!IteratorType::isIndicator && BaseModel::hasTwoNumeratorTerms) ?
+					BaseModel::gradientNumerator2Contrib(itValues.value(), offsExpXBeta[k]) :
+					static_cast<real>(0); // Unused
+			// Compile-time delegation
+			BaseModel::incrementGradientAndHessian(itValues,
+					w, // Signature-only, for iterator-type specialization
+					&gradient, &hessian, numer, numer2,
+					denomPid[k], hNWeight[k], itValues.value(), hXBeta[k], hY[k]); // When function is in-lined, compiler will only use necessary arguments
+		}
 	} else {
 		for (; it; ++it) {
 			const int k = it.index();
@@ -344,6 +471,82 @@ void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessianImpl(int ind
 	*ohessian = static_cast<double>(hessian);
 }
 
+template <class BaseModel,typename WeightType> template <class IteratorType, class Weights>
+void ModelSpecifics<BaseModel,WeightType>::computeCumulativeGradientAndHessianImpl(int index,
+		real *ogradient, real *ohessian, Weights w) {
+	/* For Cox model:
+	 *
+	 * accNumer is constant between consecutive non-zero rows, so each run of rows contributes
+	 * accNumer * (P1[end] - P1[start]) to the gradient and accNumer^2 * (P2[end] - P2[start])
+	 * to the Hessian, where P1 and P2 are prefix sums of nEvents / accDenom and
+	 * nEvents / accDenom^2.  Cost is O(nnz) once the prefix sums are known; bringing them up
+	 * to date after an update costs O(N - first changed row).
+	 */
+	if (prefixSumsValidRows < N) {
+		computePrefixSums();
+	}
+
+	double gradient = 0.0;
+	double hessian = 0.0;
+	double accNumer = 0.0;
+	double accNumer2 = 0.0;
+
+	typename IndexListIterator<IteratorType>::type it((*sparseIndices)[index], N);
+	for (; it; ) {
+		const int k = it.index();
+		const int group = BaseModel::getGroup(hPid, k);
+		if (w.isWeighted) {
+			accNumer += numerPid[group] * hKWeight[k];
+			if (!IteratorType::isIndicator) {
+				accNumer2 += numerPid2[group] * hKWeight[k];
+			}
+		} else {
+			accNumer += numerPid[group];
+			if (!IteratorType::isIndicator) {
+				accNumer2 += numerPid2[group];
+			}
+		}
+		++it;
+		const int next = it ? it.index() : N;
+
+		const double s1 = prefixInvDenom[next] - prefixInvDenom[k];
+		const double s2 = prefixInvDenom2[next] - prefixInvDenom2[k];
+		gradient += accNumer * s1;
+		if (IteratorType::isIndicator) {
+			hessian += accNumer * s1 - accNumer * accNumer * s2;
+		} else {
+			hessian += accNumer2 * s1 - accNumer * accNumer * s2;
+		}
+	}
+
+	*ogradient = static_cast<real>(gradient);
+	*ohessian = static_cast<real>(hessian);
+}
+
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::computePrefixSums() {
+	if (prefixInvDenom.size() != static_cast<size_t>(N) + 1) {
+		prefixInvDenom.resize(N + 1);
+		prefixInvDenom2.resize(N + 1);
+		prefixSumsValidRows = 0;
+	}
+	// Entries up to prefixSumsValidRows only depend on unchanged rows
+	const int first = prefixSumsValidRows;
+	double s1 = (first == 0) ? 0.0 : prefixInvDenom[first];
+	double s2 = (first == 0) ? 0.0 : prefixInvDenom2[first];
+	prefixInvDenom[first] = s1;
+	prefixInvDenom2[first] = s2;
+	for (int k = first; k < N; ++k) {
+		const double inverse = 1.0 / static_cast<double>(getAccDenom(BaseModel::getGroup(hPid, k)));
+		const double t = hNWeight[k] * inverse;
+		s1 += t;
+		s2 += t * inverse;
+		prefixInvDenom[k + 1] = s1;
+		prefixInvDenom2[k + 1] = s2;
+	}
+	prefixSumsValidRows = N;
+}
+
 template <class BaseModel,typename WeightType>
 void ModelSpecifics<BaseModel,WeightType>::computeFisherInformation(int indexOne, int indexTwo,
 		double *oinfo, bool useWeights) {
@@ -357,6 +560,12 @@ void ModelSpecifics<BaseModel,WeightType>::computeFisherInformation(int indexOne
 			case INDICATOR :
 				dispatchFisherInformation<IndicatorIterator>(indexOne, indexTwo, oinfo, weighted);
 				break;
+			case BITMAP :
+				dispatchFisherInformation<BitmapIterator>(indexOne, indexTwo, oinfo, weighted);
+				break;
+			case PACKED :
+				dispatchFisherInformation<PackedIterator>(indexOne, indexTwo, oinfo, weighted);
+				break;
 			case SPARSE :
 				dispatchFisherInformation<SparseIterator>(indexOne, indexTwo, oinfo, weighted);
 				break;
@@ -376,6 +585,12 @@ void ModelSpecifics<BaseModel,WeightType>::dispatchFisherInformation(int indexOn
 		case INDICATOR :
 			computeFisherInformationImpl<IteratorTypeOne,IndicatorIterator>(indexOne, indexTwo, oinfo, w);
 			break;
+		case BITMAP :
+			computeFisherInformationImpl<IteratorTypeOne,BitmapIterator>(indexOne, indexTwo, oinfo, w);
+			break;
+		case PACKED :
+			computeFisherInformationImpl<IteratorTypeOne,PackedIterator>(indexOne, indexTwo, oinfo, w);
+			break;
 		case SPARSE :
 			computeFisherInformationImpl<IteratorTypeOne,SparseIterator>(indexOne, indexTwo, oinfo, w);
 			break;
@@ -391,32 +606,75 @@ void ModelSpecifics<BaseModel,WeightType>::dispatchFisherInformation(int indexOn
 
 
 template<class BaseModel, typename WeightType> template<class IteratorType>
-SparseIterator ModelSpecifics<BaseModel, WeightType>::getSubjectSpecificHessianIterator(int index) {
+CrossTermCache::EntryPtr ModelSpecifics<BaseModel, WeightType>::getSubjectSpecificHessianTerms(int index) {
 
-	if (hessianSparseCrossTerms.find(index) == hessianSparseCrossTerms.end()) {
-		// Make new
-		std::vector<int>* indices = new std::vector<int>();
-		std::vector<real>* values = new std::vector<real>();
-		CompressedDataColumn* column = new CompressedDataColumn(indices, values,
-				SPARSE);
-		hessianSparseCrossTerms.insert(std::make_pair(index, column));
+	CrossTermCache::EntryPtr cached = hessianCrossTermCache.find(index);
+	if (cached) {
+		return cached;
+	}
 
-		IteratorType itCross(*hXI, index);
-		for (; itCross;) {
-			real value = 0.0;
-			int currentPid = hPid[itCross.index()];
-			do {
-				const int k = itCross.index();
-				value += BaseModel::gradientNumeratorContrib(itCross.value(),
-						offsExpXBeta[k], hXBeta[k], hY[k]);
-				++itCross;
-			} while (itCross && currentPid == hPid[itCross.index()]);
-			indices->push_back(currentPid);
-			values->push_back(value);
-		}
+	// Make new
+	std::shared_ptr<CrossTermCache::Entry> entry = hessianCrossTermCache.allocate();
+	IteratorType itCross(*hXI, index);
+	for (; itCross;) {
+		real value = 0.0;
+		int currentPid = hPid[itCross.index()];
+		do {
+			const int k = itCross.index();
+			value += BaseModel::gradientNumeratorContrib(itCross.value(),
+					offsExpXBeta[k], hXBeta[k], hY[k]);
+			++itCross;
+		} while (itCross && currentPid == hPid[itCross.index()]);
+		entry->groups.push_back(currentPid);
+		entry->values.push_back(value);
 	}
-	return SparseIterator(*hessianSparseCrossTerms[index]);
+	return hessianCrossTermCache.insert(index, entry);
+}
 
+template <class BaseModel, typename WeightType>
+bool ModelSpecifics<BaseModel,WeightType>::getFisherInformationGroups(int index,
+		std::vector<int>* groups) {
+	groups->clear();
+	switch (hXI->getFormatType(index)) {
+		case INDICATOR :
+			getFisherInformationGroupsImpl<IndicatorIterator>(index, groups);
+			return true;
+		case BITMAP :
+			getFisherInformationGroupsImpl<BitmapIterator>(index, groups);
+			return true;
+		case PACKED :
+			getFisherInformationGroupsImpl<PackedIterator>(index, groups);
+			return true;
+		case SPARSE :
+			getFisherInformationGroupsImpl<SparseIterator>(index, groups);
+			return true;
+		case DENSE :
+			if (BaseModel::hasStrataCrossTerms) { // Compile-time switch
+				getSubjectSpecificHessianTerms<DenseIterator>(index);
+			}
+			return false;
+		case INTERCEPT :
+			if (BaseModel::hasStrataCrossTerms) { // Compile-time switch
+				getSubjectSpecificHessianTerms<InterceptIterator>(index);
+			}
+			return false;
+		default :
+			// throw error
+			exit(-1);
+	}
+}
+
+template <class BaseModel, typename WeightType> template <class IteratorType>
+void ModelSpecifics<BaseModel,WeightType>::getFisherInformationGroupsImpl(int index,
+		std::vector<int>* groups) {
+	if (BaseModel::hasStrataCrossTerms) { // Compile-time switch
+		// Strata of the cross-terms column
+		*groups = getSubjectSpecificHessianTerms<IteratorType>(index)->groups;
+	} else {
+		for (IteratorType it(*hXI, index); it; ++it) {
+			groups->push_back(it.index());
+		}
+	}
 }
 
 
@@ -484,8 +742,11 @@ void ModelSpecifics<BaseModel,WeightType>::computeFisherInformationImpl(int inde
 //		std::cerr << cross << std::endl;
 		information -= cross;
 #else
-		SparseIterator sparseCrossOneTerms = getSubjectSpecificHessianIterator<IteratorTypeOne>(indexOne);
-		SparseIterator sparseCrossTwoTerms = getSubjectSpecificHessianIterator<IteratorTypeTwo>(indexTwo);
+		// Held for the loop, as either may be evicted by another thread
+		CrossTermCache::EntryPtr crossOneTerms = getSubjectSpecificHessianTerms<IteratorTypeOne>(indexOne);
+		CrossTermCache::EntryPtr crossTwoTerms = getSubjectSpecificHessianTerms<IteratorTypeTwo>(indexTwo);
+		SparseIterator sparseCrossOneTerms(crossOneTerms->groups, crossOneTerms->values);
+		SparseIterator sparseCrossTwoTerms(crossTwoTerms->groups, crossTwoTerms->values);
 		PairProductIterator<SparseIterator,SparseIterator> itSparseCross(sparseCrossOneTerms, sparseCrossTwoTerms);
 
 		real sparseCross = 0.0;
@@ -504,39 +765,28 @@ void ModelSpecifics<BaseModel,WeightType>::computeFisherInformationImpl(int inde
 
 template <class BaseModel,typename WeightType>
 void ModelSpecifics<BaseModel,WeightType>::computeNumeratorForGradient(int index) {
+	if (BaseModel::hasIndependentRows) { // Compile-time switch
+		return; // Formed row-by-row in computeGradientAndHessian
+	}
 	// Run-time delegation
 	switch (hXI->getFormatType(index)) {
-		case INDICATOR : {
-			IndicatorIterator it(*(*sparseIndices)[index]);
-			for (; it; ++it) { // Only affected entries
-				numerPid[it.index()] = static_cast<real>(0.0);
-			}
-			incrementNumeratorForGradientImpl<IndicatorIterator>(index);
-			}
+		case INDICATOR :
+			computeNumeratorForGradientImpl<IndicatorIterator>(index);
 			break;
-		case SPARSE : {
-			SparseIterator it(*(*sparseIndices)[index]);
-			for (; it; ++it) { // Only affected entries
-				numerPid[it.index()] = static_cast<real>(0.0);
-				if (BaseModel::hasTwoNumeratorTerms) { // Compile-time switch
-					numerPid2[it.index()] = static_cast<real>(0.0); // TODO Does this invalid the cache line too much?
-				}
-			}
-			incrementNumeratorForGradientImpl<SparseIterator>(index); }
+		case BITMAP :
+			computeNumeratorForGradientImpl<BitmapIterator>(index);
+			break;
+		case PACKED :
+			computeNumeratorForGradientImpl<PackedIterator>(index);
+			break;
+		case SPARSE :
+			computeNumeratorForGradientImpl<SparseIterator>(index);
 			break;
 		case DENSE :
-			zeroVector(numerPid, N);
-			if (BaseModel::hasTwoNumeratorTerms) { // Compile-time switch
-				zeroVector(numerPid2, N);
-			}
-			incrementNumeratorForGradientImpl<DenseIterator>(index);
+			computeNumeratorForGradientImpl<DenseIterator>(index);
 			break;
 		case INTERCEPT :
-			zeroVector(numerPid, N);
-			if (BaseModel::hasTwoNumeratorTerms) { // Compile-time switch
-				zeroVector(numerPid2, N);
-			}
-			incrementNumeratorForGradientImpl<InterceptIterator>(index);
+			computeNumeratorForGradientImpl<InterceptIterator>(index);
 			break;
 		default :
 			// throw error
@@ -544,8 +794,59 @@ void ModelSpecifics<BaseModel,WeightType>::computeNumeratorForGradient(int index
 	}
 }
 
+template <class BaseModel,typename WeightType> template <class IteratorType>
+void ModelSpecifics<BaseModel,WeightType>::computeNumeratorForGradientImpl(int index) {
+	if (IteratorType::isSparse) {
+		typename IndexListIterator<IteratorType>::type it((*sparseIndices)[index], N);
+		for (; it; ++it) { // Only affected entries
+			numerPid[it.index()] = static_cast<real>(0.0);
+			if (!IteratorType::isIndicator && BaseModel::hasTwoNumeratorTerms) { // Compile-time switch
+				numerPid2[it.index()] = static_cast<real>(0.0); // TODO Does this invalid the cache line too much?
+			}
+		}
+	} else {
+		zeroVector(numerPid, N);
+		if (BaseModel::hasTwoNumeratorTerms) { // Compile-time switch
+			zeroVector(numerPid2, N);
+		}
+	}
+	incrementNumeratorForGradientImpl<IteratorType>(index);
+}
+
+template <class BaseModel,typename WeightType> template <class IteratorType, bool Weighted>
+void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessianForColumn(int index,
+		double *ogradient, double *ohessian) {
+	if (!IteratorType::isSparse && simdKernels != NULL) { // DENSE or INTERCEPT
+		computeGradientAndHessianVectorized(index, ogradient, ohessian, Weighted);
+		return;
+	}
+	if (!BaseModel::hasIndependentRows) { // Compile-time switch
+		computeNumeratorForGradientImpl<IteratorType>(index);
+	}
+	if (Weighted) {
+		computeGradientAndHessianImpl<IteratorType>(index, ogradient, ohessian, weighted);
+	} else {
+		computeGradientAndHessianImpl<IteratorType>(index, ogradient, ohessian, unweighted);
+	}
+}
+
+template <class BaseModel,typename WeightType> template <class IteratorType>
+void ModelSpecifics<BaseModel,WeightType>::updateXBetaForColumn(real delta, int index, bool useWeights) {
+	if (!IteratorType::isSparse && simdKernels != NULL) { // DENSE or INTERCEPT
+		updateXBetaVectorized(delta, index, useWeights);
+	} else {
+		updateXBetaImpl<IteratorType>(delta, index, useWeights);
+	}
+}
+
 template <class BaseModel,typename WeightType> template <class IteratorType>
 void ModelSpecifics<BaseModel,WeightType>::incrementNumeratorForGradientImpl(int index) {
+	if (!IteratorType::isSparse && !BaseModel::hasIndependentRows) { // Compile-time switch
+		// Every row contributes, so reduce each stratum's run in place of a scatter
+		buildStrataOffsets();
+		forStrataBlocks(&ModelSpecifics::template incrementNumeratorForStrata<IteratorType>, index);
+		return;
+	}
 	IteratorType it(*hXI, index);
 	for (; it; ++it) {
 		const int k = it.index();
@@ -571,13 +872,103 @@ void ModelSpecifics<BaseModel,WeightType>::incrementNumeratorForGradientImpl(int
 	}
 }
 
+template <class BaseModel,typename WeightType> template <class IteratorType>
+void ModelSpecifics<BaseModel,WeightType>::incrementNumeratorForStrata(int index, int first,
+		int last) {
+	const real* x = hXI->getFormatType(index) == DENSE ? hXI->getDataVector(index) : NULL;
+	for (int i = first; i < last; ++i) {
+		real numer = static_cast<real>(0);
+		real numer2 = static_cast<real>(0);
+		for (int k = strataOffsets[i]; k < strataOffsets[i + 1]; ++k) {
+			const real value = x ? x[k] : static_cast<real>(1);
+			numer += BaseModel::gradientNumeratorContrib(value, offsExpXBeta[k], hXBeta[k], hY[k]);
+			if (!IteratorType::isIndicator && BaseModel::hasTwoNumeratorTerms) {
+				numer2 += BaseModel::gradientNumerator2Contrib(value, offsExpXBeta[k]);
+			}
+		}
+		numerPid[i] = numer;
+		if (!IteratorType::isIndicator && BaseModel::hasTwoNumeratorTerms) {
+			numerPid2[i] = numer2;
+		}
+	}
+}
+
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::computeDenominatorsForStrata(int first, int last) {
+	for (int i = first; i < last; ++i) {
+		real denom = BaseModel::getDenomNullValue();
+		for (int k = strataOffsets[i]; k < strataOffsets[i + 1]; ++k) {
+			offsExpXBeta[k] = BaseModel::getOffsExpXBeta(hOffs, hXBeta[k], hY[k], k);
+			denom += offsExpXBeta[k];
+		}
+		denomPid[i] = denom;
+	}
+}
+
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::buildStrataOffsets(void) {
+	if (static_cast<int>(strataOffsets.size()) == N + 1) {
+		return;
+	}
+	strataOffsets.assign(1, 0);
+	strataOffsets.reserve(N + 1);
+	for (int k = 1; k < K; ++k) {
+		if (hPid[k] != hPid[k - 1]) {
+			strataOffsets.push_back(k);
+		}
+	}
+	strataOffsets.push_back(K);
+	if (static_cast<int>(strataOffsets.size()) != N + 1) {
+		std::cerr << "Strata are not contiguous runs of rows" << std::endl;
+		exit(-1);
+	}
+}
+
+template <class BaseModel,typename WeightType> template <typename Method, typename... Args>
+void ModelSpecifics<BaseModel,WeightType>::forStrataBlocks(Method method, Args... args) {
+	// Threads are started on every call, so each must get enough rows to amortize its start-up
+	// (tens of microseconds against a few nanoseconds per row)
+	const int minRowsPerThread = 1 << 18;
+	const int threads = std::min(nThreads, K / minRowsPerThread);
+	if (threads <= 1) {
+		(this->*method)(args..., 0, N);
+		return;
+	}
+	// Block t starts at the stratum holding row K * t / threads
+	std::vector<int> firstStratum(threads + 1, N);
+	firstStratum[0] = 0;
+	for (int t = 1; t < threads; ++t) {
+		const int row = static_cast<int>(static_cast<long>(K) * t / threads);
+		firstStratum[t] = std::upper_bound(strataOffsets.begin(), strataOffsets.end(), row)
+				- strataOffsets.begin() - 1;
+	}
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; ++t) {
+		workers.push_back(std::thread(method, this, args..., firstStratum[t], firstStratum[t + 1]));
+	}
+	(this->*method)(args..., firstStratum[0], firstStratum[1]);
+	for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+		it->join();
+	}
+}
+
 template <class BaseModel,typename WeightType>
 void ModelSpecifics<BaseModel,WeightType>::updateXBeta(real realDelta, int index, bool useWeights) {
+	if (isVectorized(index)) {
+		updateXBetaVectorized(realDelta, index, useWeights);
+		return;
+	}
 	// Run-time dispatch to implementation depending on covariate FormatType
 	switch(hXI->getFormatType(index)) {
 		case INDICATOR :
 			updateXBetaImpl<IndicatorIterator>(realDelta, index, useWeights);
 			break;
+		case BITMAP :
+			updateXBetaImpl<BitmapIterator>(realDelta, index, useWeights);
+			break;
+		case PACKED :
+			updateXBetaImpl<PackedIterator>(realDelta, index, useWeights);
+			break;
 		case SPARSE :
 			updateXBetaImpl<SparseIterator>(realDelta, index, useWeights);
 			break;
@@ -595,97 +986,258 @@ void ModelSpecifics<BaseModel,WeightType>::updateXBeta(real realDelta, int index
 
 template <class BaseModel,typename WeightType> template <class IteratorType>
 inline void ModelSpecifics<BaseModel,WeightType>::updateXBetaImpl(real realDelta, int index, bool useWeights) {
+	// y * xBeta is linear, so the GLM numerator moves by delta * XjY without visiting rows
+	const bool trackNumerator = logLikelihoodKnown && !BaseModel::precomputeGradient;
+	const bool trackStrata = logLikelihoodKnown && !denomAllDirty;
+	if (BaseModel::precomputeGradient && logLikelihoodKnown) { // Compile-time switch
+		logLikelihoodNumerator += realDelta * hXjY[index];
+	}
+	real factor = static_cast<real>(1);
+	if (BaseModel::likelihoodHasDenominator && IteratorType::isIndicator) { // Compile-time switch
+		factor = std::exp(realDelta);
+		if (static_cast<int>(offsExpXBetaScalings.size()) != K) {
+			offsExpXBetaScalings.assign(K, 0);
+		}
+	}
 	IteratorType it(*hXI, index);
 	for (; it; ++it) {
 		const int k = it.index();
+		const real oldXBeta = hXBeta[k];
 		hXBeta[k] += realDelta * it.value(); // TODO Check optimization with indicator and intercept
+		if (trackNumerator) {
+			real contrib = BaseModel::logLikeNumeratorContrib(hY[k], hXBeta[k])
+					- BaseModel::logLikeNumeratorContrib(hY[k], oldXBeta);
+			if (useWeights) {
+				contrib *= hKWeight[k];
+			}
+			logLikelihoodNumerator += contrib;
+		}
 		// Update denominators as well
 		if (BaseModel::likelihoodHasDenominator) { // Compile-time switch
 			real oldEntry = offsExpXBeta[k];
-			real newEntry = offsExpXBeta[k] = BaseModel::getOffsExpXBeta(hOffs, hXBeta[k], hY[k], k);
+			real newEntry;
+			if (IteratorType::isIndicator &&
+					++offsExpXBetaScalings[k] < offsExpXBetaRefreshInterval) { // x_k == 1
+				newEntry = offsExpXBeta[k] = oldEntry * factor;
+			} else {
+				if (IteratorType::isIndicator) {
+					offsExpXBetaScalings[k] = 0;
+				}
+				newEntry = offsExpXBeta[k] = BaseModel::getOffsExpXBeta(hOffs, hXBeta[k], hY[k], k);
+			}
 			incrementByGroup(denomPid, hPid, k, (newEntry - oldEntry));
+			if (BaseModel::cumulativeGradientAndHessian) {
+				markAccDenomDirty(BaseModel::getGroup(hPid, k));
+			}
+			if (trackStrata && !BaseModel::cumulativeGradientAndHessian) {
+				const int group = BaseModel::getGroup(hPid, k);
+				if (!denomDirty[group]) {
+					denomDirty[group] = 1;
+					dirtyStrata.push_back(group);
+				}
+			}
 		}
 	}
 	computeAccumlatedNumerDenom(useWeights);
 }
 
+template <class BaseModel,typename WeightType>
+bool ModelSpecifics<BaseModel,WeightType>::isVectorized(int index) {
+	return simdKernels != NULL &&
+			(hXI->getFormatType(index) == DENSE || hXI->getFormatType(index) == INTERCEPT);
+}
+
+template <class BaseModel,typename WeightType>
+const real* ModelSpecifics<BaseModel,WeightType>::getVectorizedColumn(int index) {
+	return hXI->getFormatType(index) == DENSE ? hXI->getDataVector(index) : NULL; // NULL for INTERCEPT
+}
+
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::updateXBetaVectorized(real realDelta, int index, bool useWeights) {
+	if (BaseModel::likelihoodHasDenominator) { // Compile-time switch; offsExpXBeta = exp(xBeta)
+		simdKernels->updateXBetaExp(K, realDelta, getVectorizedColumn(index),
+				hXBeta, offsExpXBeta, denomPid);
+		if (logLikelihoodKnown) {
+			logLikelihoodNumerator += realDelta * hXjY[index];
+			denomAllDirty = true; // Every row is its own stratum
+		}
+	} else {
+		const double change = simdKernels->updateXBeta(K, realDelta, getVectorizedColumn(index),
+				hXBeta, logLikelihoodKnown ? hY : NULL,
+				logLikelihoodKnown && useWeights ? hKWeight.data() : NULL);
+		logLikelihoodNumerator += change;
+	}
+}
+
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::computeGradientAndHessianVectorized(int index,
+		double *ogradient, double *ohessian, bool useWeights) {
+	real gradient;
+	real hessian;
+	BaseModel::denseGradientAndHessian(*simdKernels, N, getVectorizedColumn(index),
+			offsExpXBeta, hXBeta, hY, denomPid,
+			useWeights ? hNWeight.data() : NULL, &gradient, &hessian);
+
+	if (BaseModel::precomputeGradient) { // Compile-time switch
+		gradient -= hXjY[index];
+	}
+
+	if (BaseModel::precomputeHessian) { // Compile-time switch
+		hessian += static_cast<real>(2.0) * hXjX[index];
+	}
+
+	*ogradient = static_cast<double>(gradient);
+	*ohessian = static_cast<double>(hessian);
+}
+
 template <class BaseModel,typename WeightType>
 void ModelSpecifics<BaseModel,WeightType>::computeRemainingStatistics(bool useWeights) {
+	logLikelihoodKnown = false;
 	if (BaseModel::likelihoodHasDenominator) {
-		fillVector(denomPid, N, BaseModel::getDenomNullValue());
-		for (int k = 0; k < K; ++k) {
-			offsExpXBeta[k] = BaseModel::getOffsExpXBeta(hOffs, hXBeta[k], hY[k], k);
-			incrementByGroup(denomPid, hPid, k, offsExpXBeta[k]);
+		if (BaseModel::hasIndependentRows) { // Compile-time switch
+			fillVector(denomPid, N, BaseModel::getDenomNullValue());
+			for (int k = 0; k < K; ++k) {
+				offsExpXBeta[k] = BaseModel::getOffsExpXBeta(hOffs, hXBeta[k], hY[k], k);
+				incrementByGroup(denomPid, hPid, k, offsExpXBeta[k]);
+			}
+		} else {
+			buildStrataOffsets();
+			forStrataBlocks(&ModelSpecifics::computeDenominatorsForStrata);
 		}
+		offsExpXBetaScalings.assign(K, 0);
+		accDenomAllDirty = true;
 		computeAccumlatedNumerDenom(useWeights);
 	}
 #ifdef DEBUG_COX
 	cerr << "Done with initial denominators" << endl;
 
 	for (int k = 0; k < K; ++k) {
-		cerr << denomPid[k] << " " << accDenomPid[k] << " " << numerPid[k] << endl;
+		cerr << denomPid[k] << " " << getAccDenom(k) << " " << numerPid[k] << endl;
 	}
 #endif
 }
 
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::markAccDenomDirty(int i) {
+	if (accDenomAllDirty) {
+		return;
+	}
+	const int block = i / accDenomBlockSize;
+	if (!accDenomBlockDirty[block]) {
+		accDenomBlockDirty[block] = 1;
+		accDenomDirtyBlocks.push_back(block);
+		if (2 * static_cast<int>(accDenomDirtyBlocks.size()) > accDenomBlocks) {
+			accDenomAllDirty = true; // Cheaper to rescan everything
+		}
+	}
+}
+
+template <class BaseModel,typename WeightType>
+void ModelSpecifics<BaseModel,WeightType>::scanAccDenomBlocks(const std::vector<int>* blocks,
+		int first, int last) {
+	// Rescans blocks [first, last), or (*blocks)[first, last) when given a list
+	for (int i = first; i < last; ++i) {
+		const int block = blocks ? (*blocks)[i] : i;
+		const int begin = block * accDenomBlockSize;
+		const int end = std::min(K, begin + accDenomBlockSize);
+		real totalTrain = static_cast<real>(0);
+		real totalValid = static_cast<real>(0);
+		if (accDenomUseWeights) {
+			//accumulating separately over train and validation sets
+			for (int k = begin; k < end; ++k) {
+				if (hKWeight[k] == 1.0) {
+					totalTrain += denomPid[k];
+					accDenomPid[k] = totalTrain;
+				} else {
+					totalValid += denomPid[k];
+					accDenomPid[k] = totalValid;
+				}
+			}
+		} else {
+			for (int k = begin; k < end; ++k) {
+				totalTrain += denomPid[k];
+				accDenomPid[k] = totalTrain;
+			}
+		}
+		accDenomTotal[2 * block] = totalTrain;
+		accDenomTotal[2 * block + 1] = totalValid;
+	}
+}
+
 template <class BaseModel,typename WeightType>
 void ModelSpecifics<BaseModel,WeightType>::computeAccumlatedNumerDenom(bool useWeights) {
 
 	if (BaseModel::likelihoodHasDenominator && //The two switches should ideally be separated
 		BaseModel::cumulativeGradientAndHessian) { // Compile-time switch
+
 			if (accDenomPid.size() != K) {
 				accDenomPid.resize(K, static_cast<real>(0));
+				accDenomBlockSize = std::max(64, static_cast<int>(std::sqrt(static_cast<double>(K))));
+				accDenomBlocks = (K + accDenomBlockSize - 1) / accDenomBlockSize;
+				accDenomTotal.resize(2 * accDenomBlocks);
+				accDenomOffset.resize(2 * accDenomBlocks);
+				accDenomBlockDirty.resize(accDenomBlocks);
+				accDenomAllDirty = true;
+			}
+			if (useWeights != accDenomUseWeights) {
+				accDenomUseWeights = useWeights;
+				accDenomAllDirty = true;
 			}
-			if (accNumerPid.size() != K) {
-				accNumerPid.resize(K, static_cast<real>(0));
-			}
-			if (accNumerPid2.size() != K) {
-				accNumerPid2.resize(K, static_cast<real>(0));
-			}
-
-			// prefix-scan
-			if(useWeights) { 
-				//accumulating separately over train and validation sets
-				real totalDenomTrain = static_cast<real>(0);
-				real totalNumerTrain = static_cast<real>(0);
-				real totalNumer2Train = static_cast<real>(0);
-				real totalDenomValid = static_cast<real>(0);
-				real totalNumerValid = static_cast<real>(0);
-				real totalNumer2Valid = static_cast<real>(0);
-				for (int k = 0; k < K; ++k) {
-					if(hKWeight[k] == 1.0){
-						totalDenomTrain += denomPid[k];
-						totalNumerTrain += numerPid[k];
-						totalNumer2Train += numerPid2[k];
-						accDenomPid[k] = totalDenomTrain;
-						accNumerPid[k] = totalNumerTrain;
-						accNumerPid2[k] = totalNumer2Train;
-					} else {
-						totalDenomValid += denomPid[k];
-						totalNumerValid += numerPid[k];
-						totalNumer2Valid += numerPid2[k];
-						accDenomPid[k] = totalDenomValid;
-						accNumerPid[k] = totalNumerValid;
-						accNumerPid2[k] = totalNumer2Valid;
+
+			// Block-local prefix-scans
+			int firstBlock = 0;
+			if (accDenomAllDirty) {
+				const int minBlocksPerThread = std::max(1, (1 << 16) / accDenomBlockSize);
+				const int threads = std::min(nThreads, accDenomBlocks / minBlocksPerThread);
+				if (threads > 1) {
+					std::vector<std::thread> workers;
+					const int chunk = (accDenomBlocks + threads - 1) / threads;
+					for (int t = 1; t < threads; ++t) {
+						workers.push_back(std::thread(&ModelSpecifics::scanAccDenomBlocks, this,
+								static_cast<const std::vector<int>*>(NULL),
+								std::min(accDenomBlocks, t * chunk),
+								std::min(accDenomBlocks, (t + 1) * chunk)));
+					}
+					scanAccDenomBlocks(NULL, 0, std::min(accDenomBlocks, chunk));
+					for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+						it->join();
 					}
+				} else {
+					scanAccDenomBlocks(NULL, 0, accDenomBlocks);
 				}
+				std::fill(accDenomBlockDirty.begin(), accDenomBlockDirty.end(), 0);
 			} else {
-				real totalDenom = static_cast<real>(0);
-				real totalNumer = static_cast<real>(0);
-				real totalNumer2 = static_cast<real>(0);
-				for (int k = 0; k < K; ++k) {
-					totalDenom += denomPid[k];
-					totalNumer += numerPid[k];
-					totalNumer2 += numerPid2[k];
-					accDenomPid[k] = totalDenom;
-					accNumerPid[k] = totalNumer;
-					accNumerPid2[k] = totalNumer2;
-#ifdef DEBUG_COX
-					cerr << denomPid[k] << " " << accDenomPid[k] << " (beta)" << endl;
-#endif
+				if (accDenomDirtyBlocks.empty()) {
+					return;
+				}
+				scanAccDenomBlocks(&accDenomDirtyBlocks, 0, accDenomDirtyBlocks.size());
+				firstBlock = accDenomBlocks;
+				for (std::vector<int>::const_iterator it = accDenomDirtyBlocks.begin();
+						it != accDenomDirtyBlocks.end(); ++it) {
+					accDenomBlockDirty[*it] = 0;
+					firstBlock = std::min(firstBlock, *it);
 				}
-
 			}
+			accDenomDirtyBlocks.clear();
+			accDenomAllDirty = false;
+
+			// Prefix-scan over block totals from the first changed block
+			real offsetTrain = static_cast<real>(0);
+			real offsetValid = static_cast<real>(0);
+			if (firstBlock > 0) {
+				offsetTrain = accDenomOffset[2 * (firstBlock - 1)] + accDenomTotal[2 * (firstBlock - 1)];
+				offsetValid = accDenomOffset[2 * firstBlock - 1] + accDenomTotal[2 * firstBlock - 1];
+			}
+			for (int block = firstBlock; block < accDenomBlocks; ++block) {
+				accDenomOffset[2 * block] = offsetTrain;
+				accDenomOffset[2 * block + 1] = offsetValid;
+				offsetTrain += accDenomTotal[2 * block];
+				offsetValid += accDenomTotal[2 * block + 1];
+			}
+
+			// Rows are sorted by group, so prefix sums before the first changed group stay valid
+			const int firstRow = std::lower_bound(hPid, hPid + N, firstBlock * accDenomBlockSize) - hPid;
+			prefixSumsValidRows = std::min(prefixSumsValidRows, firstRow);
 	}
 }
 
@@ -0,0 +1,83 @@
+/*
+ * RegularizationPath.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef REGULARIZATIONPATH_H_
+#define REGULARIZATIONPATH_H_
+
+#include <cmath>
+
+#include "CyclicCoordinateDescent.h"
+#include "ccd.h"
+
+namespace bsccs {
+
+/*
+ * Log-uniform sequence of prior variances, ordered from the strongest penalty (lowerLimit)
+ * to the weakest (upperLimit).  Fitting walks the sequence on one engine, so each fit
+ * warm-starts from the previous hBeta, hXBeta and denominators.
+ */
+class RegularizationPath {
+public:
+	RegularizationPath(
+			int iGridSize,
+			double iLowerLimit,
+			double iUpperLimit) : gridSize(iGridSize),
+			lowerLimit(iLowerLimit), upperLimit(iUpperLimit) {
+		// Do nothing
+	}
+
+	int getSize() const {
+		return gridSize;
+	}
+
+	double getPoint(int step) const {
+		return getPoint(step, gridSize, lowerLimit, upperLimit);
+	}
+
+	// Shared with the grid-search cross-validation driver
+	static double getPoint(int step, int gridSize, double lowerLimit, double upperLimit) {
+		if (gridSize == 1) {
+			return upperLimit;
+		}
+		// Log uniform grid
+		double stepSize = (log(upperLimit) - log(lowerLimit)) / (gridSize - 1);
+		return exp(log(lowerLimit) + step * stepSize);
+	}
+
+	// Fits steps [0, lastStep) and calls observer(step, point, ccd) after each fit
+	template <typename Observer>
+	void fit(
+			CyclicCoordinateDescent& ccd,
+			const CCDArguments& arguments,
+			Observer& observer,
+			int lastStep = -1) const {
+		if (lastStep < 0) {
+			lastStep = gridSize;
+		}
+		for (int step = 0; step < lastStep; ++step) {
+			const double point = getPoint(step);
+			ccd.setHyperprior(point);
+			ccd.update(arguments.maxIterations, arguments.convergenceType, arguments.tolerance);
+			observer(step, point, ccd);
+		}
+	}
+
+	struct NoObserver {
+		void operator()(int step, double point, CyclicCoordinateDescent& ccd) {
+			// Do nothing
+		}
+	};
+
+private:
+	int gridSize;
+	double lowerLimit;
+	double upperLimit;
+};
+
+} // namespace
+
+#endif /* REGULARIZATIONPATH_H_ */
@@ -0,0 +1,90 @@
+/*
+ * RegularizationPathDriver.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+#include "RegularizationPathDriver.h"
+
+namespace bsccs {
+
+RegularizationPathDriver::RegularizationPathDriver(
+		int iGridSize,
+		double iLowerLimit,
+		double iUpperLimit,
+		ModelData* inModelData) : path(iGridSize, iLowerLimit, iUpperLimit),
+		modelData(inModelData) {
+	// Do nothing
+}
+
+RegularizationPathDriver::~RegularizationPathDriver() {
+	// Do nothing
+}
+
+void RegularizationPathDriver::drive(
+		CyclicCoordinateDescent& ccd,
+		AbstractSelector& selector,
+		const CCDArguments& arguments) {
+	drive(ccd, arguments);
+}
+
+void RegularizationPathDriver::drive(
+		CyclicCoordinateDescent& ccd,
+		const CCDArguments& arguments) {
+
+	pathPoint.clear();
+	pathBeta.clear();
+	pathPoint.reserve(path.getSize());
+	pathBeta.reserve(path.getSize());
+
+	// Engine is left at the weakest penalty
+	path.fit(ccd, arguments, *this);
+}
+
+void RegularizationPathDriver::operator()(int step, double point, CyclicCoordinateDescent& ccd) {
+	const int J = ccd.getBetaSize();
+	std::vector<double> beta(J);
+	for (int j = 0; j < J; ++j) {
+		beta[j] = ccd.getBeta(j);
+	}
+	pathPoint.push_back(point);
+	pathBeta.push_back(beta);
+
+	std::cout << "Path point " << (step + 1) << " of " << path.getSize()
+			<< " at " << ccd.getPriorInfo() << std::endl;
+}
+
+void RegularizationPathDriver::logResults(const CCDArguments& arguments) {
+
+	ofstream outLog(arguments.pathFileName.c_str());
+	if (!outLog) {
+		cerr << "Unable to open log file: " << arguments.pathFileName << endl;
+		exit(-1);
+	}
+
+	string sep(","); // TODO Make option
+
+	// One row per covariate, one column per point on the path
+	outLog << "variance";
+	for (size_t step = 0; step < pathPoint.size(); ++step) {
+		outLog << sep << pathPoint[step];
+	}
+	outLog << endl;
+
+	const int J = modelData->getNumberOfColumns();
+	for (int j = 0; j < J; ++j) {
+		outLog << modelData->getColumn(j).getLabel();
+		for (size_t step = 0; step < pathBeta.size(); ++step) {
+			outLog << sep << pathBeta[step][j];
+		}
+		outLog << endl;
+	}
+	outLog.close();
+}
+
+} // namespace
@@ -0,0 +1,52 @@
+/*
+ * RegularizationPathDriver.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef REGULARIZATIONPATHDRIVER_H_
+#define REGULARIZATIONPATHDRIVER_H_
+
+#include <vector>
+
+#include "AbstractDriver.h"
+#include "ModelData.h"
+#include "RegularizationPath.h"
+
+namespace bsccs {
+
+class RegularizationPathDriver : public AbstractDriver {
+public:
+	RegularizationPathDriver(
+			int iGridSize,
+			double iLowerLimit,
+			double iUpperLimit,
+			ModelData* inModelData);
+
+	virtual ~RegularizationPathDriver();
+
+	void drive(
+			CyclicCoordinateDescent& ccd,
+			const CCDArguments& arguments);
+
+	virtual void drive(
+			CyclicCoordinateDescent& ccd,
+			AbstractSelector& selector,
+			const CCDArguments& arguments);
+
+	virtual void logResults(const CCDArguments& arguments);
+
+	// Stores the coefficients at each point of the path
+	void operator()(int step, double point, CyclicCoordinateDescent& ccd);
+
+private:
+	RegularizationPath path;
+	ModelData* modelData;
+	std::vector<double> pathPoint;
+	std::vector<std::vector<double> > pathBeta;
+};
+
+} // namespace
+
+#endif /* REGULARIZATIONPATHDRIVER_H_ */
@@ -0,0 +1,149 @@
+/*
+ * SparseIndices.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include <algorithm>
+#include <thread>
+
+#include "SparseIndices.h"
+#include "CompressedDataMatrix.h"
+#include "Iterators.h"
+
+namespace bsccs {
+
+namespace {
+
+// As collectStrata, for iterators whose rows arrive in increasing order
+template <class IteratorType>
+int collectSortedStrata(IteratorType it, const int* pid, int* out) {
+	int count = 0;
+	int last = -1;
+	for (; it; ++it) {
+		const int stratum = pid[it.index()];
+		if (stratum != last) {
+			if (out) {
+				out[count] = stratum;
+			}
+			++count;
+			last = stratum;
+		}
+	}
+	return count;
+}
+
+/*
+ * Writes the distinct strata of column j to out (when not NULL) and returns their number.
+ * Rows arrive in increasing order and pid is non-decreasing, so duplicates are adjacent;
+ * a column with unsorted rows falls back to sorting a copy.
+ */
+int collectStrata(const CompressedDataMatrix& matrix, const int* pid, int j, int* out) {
+	const FormatType format = matrix.getFormatType(j);
+	if (format == BITMAP) {
+		return collectSortedStrata(BitmapIterator(matrix, j), pid, out);
+	} else if (format == PACKED) {
+		return collectSortedStrata(PackedIterator(matrix, j), pid, out);
+	}
+	if (format != SPARSE && format != INDICATOR) {
+		return 0;
+	}
+	const int* rows = matrix.getCompressedColumnVector(j);
+	const int n = matrix.getNumberOfEntries(j);
+
+	int count = 0;
+	int last = -1;
+	for (int i = 0; i < n; ++i) {
+		const int stratum = pid[rows[i]];
+		if (stratum < last) { // Unsorted rows
+			std::vector<int> strata(n);
+			for (int r = 0; r < n; ++r) {
+				strata[r] = pid[rows[r]];
+			}
+			std::sort(strata.begin(), strata.end());
+			strata.erase(std::unique(strata.begin(), strata.end()), strata.end());
+			if (out) {
+				std::copy(strata.begin(), strata.end(), out);
+			}
+			return strata.size();
+		}
+		if (stratum != last) {
+			if (out) {
+				out[count] = stratum;
+			}
+			++count;
+			last = stratum;
+		}
+	}
+	return count;
+}
+
+void countStrata(const CompressedDataMatrix* matrix, const int* pid, size_t* counts,
+		int begin, int end) {
+	for (int j = begin; j < end; ++j) {
+		counts[j + 1] = collectStrata(*matrix, pid, j, NULL);
+	}
+}
+
+void fillStrata(const CompressedDataMatrix* matrix, const int* pid, const size_t* offsets,
+		int* indices, int begin, int end) {
+	for (int j = begin; j < end; ++j) {
+		collectStrata(*matrix, pid, j, indices + offsets[j]);
+	}
+}
+
+// Runs task(begin, end) over threads contiguous blocks of [0, n); threads = 1 runs in place
+template <typename Task, typename... Args>
+void forColumnBlocks(int n, int threads, Task task, Args... args) {
+	if (threads <= 1) {
+		task(args..., 0, n);
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		const int begin = static_cast<int>(static_cast<long>(n) * t / threads);
+		const int end = static_cast<int>(static_cast<long>(n) * (t + 1) / threads);
+		workers.push_back(std::thread(task, args..., begin, end));
+	}
+	for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+		it->join();
+	}
+}
+
+const int minColumnsPerThread = 256;
+
+} // namespace
+
+SparseIndices::SparseIndices() : offsets(1, 0) {
+	// Do nothing
+}
+
+SparseIndices::~SparseIndices() {
+	// Do nothing
+}
+
+void SparseIndices::build(const CompressedDataMatrix& matrix, const int* pid, int threads) {
+	const int nColumns = matrix.getNumberOfColumns();
+	threads = std::max(1, std::min(threads, nColumns / minColumnsPerThread));
+
+	std::vector<size_t> newOffsets(nColumns + 1, 0);
+	forColumnBlocks(nColumns, threads, countStrata, &matrix, pid, newOffsets.data());
+	for (int j = 0; j < nColumns; ++j) {
+		newOffsets[j + 1] += newOffsets[j];
+	}
+
+	std::vector<int> newIndices(newOffsets.back());
+	forColumnBlocks(nColumns, threads, fillStrata, &matrix, pid,
+			static_cast<const size_t*>(newOffsets.data()), newIndices.data());
+
+	indices.swap(newIndices);
+	offsets.swap(newOffsets);
+}
+
+void SparseIndices::clear(int nColumns) {
+	std::vector<int>().swap(indices);
+	offsets.assign(nColumns + 1, 0);
+}
+
+} // namespace
@@ -0,0 +1,66 @@
+/*
+ * SparseIndices.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef SPARSEINDICES_H_
+#define SPARSEINDICES_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace bsccs {
+
+class CompressedDataMatrix; // forward declaration
+
+// Read-only view of one column's list in SparseIndices
+struct IndexList {
+	const int* indices;
+	int size;
+};
+
+/*
+ * Per-column lists of the strata (renumbered pids) in which the column has an entry, in
+ * increasing order and stored back to back in one arena.  DENSE and INTERCEPT columns, and
+ * every column when the lists are not built, have empty lists.
+ */
+class SparseIndices {
+public:
+	SparseIndices();
+
+	virtual ~SparseIndices();
+
+	/**
+	 * Builds all lists in O(nnz) with up to threads workers over columns.  pid must be
+	 * non-decreasing in row order, as after renumbering into contiguous runs.
+	 */
+	void build(const CompressedDataMatrix& matrix, const int* pid, int threads);
+
+	// Empty lists for all columns, e.g. for models whose rows are their own strata
+	void clear(int nColumns);
+
+	IndexList operator[](int column) const {
+		const size_t begin = offsets[column];
+		IndexList list = { indices.data() + begin,
+				static_cast<int>(offsets[column + 1] - begin) };
+		return list;
+	}
+
+	int getNumberOfColumns(void) const {
+		return offsets.size() - 1;
+	}
+
+private:
+	std::vector<int> indices;
+	std::vector<size_t> offsets; // nColumns + 1 offsets into indices
+
+	// Disable copy-constructors and copy-assignment
+	SparseIndices(const SparseIndices&);
+	SparseIndices& operator = (const SparseIndices&);
+};
+
+} // namespace
+
+#endif /* SPARSEINDICES_H_ */
@@ -0,0 +1,173 @@
+/*
+ * StaticCyclicCoordinateDescent.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef STATICCYCLICCOORDINATEDESCENT_H_
+#define STATICCYCLICCOORDINATEDESCENT_H_
+
+#include "CyclicCoordinateDescent.h"
+#include "ModelSpecifics.h"
+#include "Iterators.h"
+#include "priors/JointPrior.h"
+
+namespace bsccs {
+
+/*
+ * Engine whose update cycle is instantiated for one (model, prior) pair and for weighted or
+ * unweighted data.  The cycle walks the per-format runs of the active set with a fixed
+ * iterator type, so each coordinate update is inlined, non-virtual calls into ModelSpecifics
+ * and the prior.  Everything outside the cycle (likelihood, variance, prediction) is shared
+ * with the base engine.
+ */
+template <class BaseModel, class Prior>
+class StaticCyclicCoordinateDescent : public CyclicCoordinateDescent {
+public:
+	typedef ModelSpecifics<BaseModel,real> Specifics;
+
+	StaticCyclicCoordinateDescent(
+			ModelData* modelData,
+			Specifics& _specifics,
+			priors::JointPriorPtr prior,
+			const Prior& _covariatePrior
+		) : CyclicCoordinateDescent(modelData, _specifics, prior),
+			specifics(_specifics), covariatePrior(_covariatePrior) {
+		// Do nothing
+	}
+
+	virtual ~StaticCyclicCoordinateDescent() {
+		// Do nothing
+	}
+
+	using CyclicCoordinateDescent::clone;
+
+	CyclicCoordinateDescent* clone(ModelData* data) {
+		Specifics* copySpecifics = static_cast<Specifics*>(specifics.clone(*data));
+		priors::JointPriorPtr copyPrior = jointPrior->clone();
+		StaticCyclicCoordinateDescent* copy = new StaticCyclicCoordinateDescent(data,
+				*copySpecifics, copyPrior, *getCovariatePrior(copyPrior));
+		copy->ownedModelSpecifics = copySpecifics;
+		copySettings(*copy);
+		return copy;
+	}
+
+	// Returns the shared covariate prior if it has type Prior, otherwise NULL
+	static const Prior* getCovariatePrior(const priors::JointPriorPtr& prior) {
+		const priors::FullyExchangeableJointPrior* exchangeable =
+				dynamic_cast<const priors::FullyExchangeableJointPrior*>(prior.get());
+		return exchangeable ? dynamic_cast<const Prior*>(exchangeable->getPrior().get()) : NULL;
+	}
+
+protected:
+	void updateCycle(void) {
+		if (useCrossValidation) {
+			updateCycleImpl<true>();
+		} else {
+			updateCycleImpl<false>();
+		}
+	}
+
+private:
+	template <bool Weighted>
+	void updateCycleImpl(void) {
+		int count = 0;
+		for (int f = 0; f < CYCLE_FORMAT_COUNT; ++f) {
+			// Run-time dispatch once per format
+			switch (cycleFormatOrder[f]) {
+				case INDICATOR :
+					updateColumns<IndicatorIterator, Weighted>(activeSetByFormat[INDICATOR], count);
+					break;
+				case BITMAP :
+					updateColumns<BitmapIterator, Weighted>(activeSetByFormat[BITMAP], count);
+					break;
+				case PACKED :
+					updateColumns<PackedIterator, Weighted>(activeSetByFormat[PACKED], count);
+					break;
+				case SPARSE :
+					updateColumns<SparseIterator, Weighted>(activeSetByFormat[SPARSE], count);
+					break;
+				case DENSE :
+					updateColumns<DenseIterator, Weighted>(activeSetByFormat[DENSE], count);
+					break;
+				case INTERCEPT :
+					updateColumns<InterceptIterator, Weighted>(activeSetByFormat[INTERCEPT], count);
+					break;
+				default :
+					// throw error
+					exit(-1);
+			}
+		}
+	}
+
+	template <class IteratorType, bool Weighted>
+	void updateColumns(const std::vector<int>& columns, int& count) {
+		for (int i = 0; i < static_cast<int>(columns.size()); i++) {
+			const int index = columns[i];
+
+			if (!fixBeta[index]) {
+				updateCoordinate<IteratorType, Weighted>(index);
+			}
+
+			if ( (noiseLevel > QUIET) && (++count % 100 == 0)) {
+				cout << "Finished variable " << count << endl;
+			}
+		}
+	}
+
+	template <class IteratorType, bool Weighted>
+	void updateCoordinate(int index) {
+		priors::GradientHessian gh;
+		specifics.template computeGradientAndHessianForColumn<IteratorType, Weighted>(index,
+				&gh.first, &gh.second);
+
+		double delta = covariatePrior.Prior::getDelta(gh, hBeta[index]); // Non-virtual call
+		delta = applyBounds(delta, index);
+		if (delta != 0.0) {
+			hBeta[index] += delta;
+			specifics.template updateXBetaForColumn<IteratorType>(static_cast<real>(delta),
+					index, Weighted);
+		}
+	}
+
+	Specifics& specifics;
+	const Prior& covariatePrior;
+};
+
+/*
+ * Factory for the engine over ModelSpecifics<BaseModel,real>: a statically dispatched engine
+ * for the exchangeable Laplace, normal and flat priors, and the virtual-dispatch engine for
+ * anything else (e.g. mixtures of priors)
+ */
+template <class BaseModel>
+CyclicCoordinateDescent* createCyclicCoordinateDescent(
+		ModelData* modelData,
+		AbstractModelSpecifics& abstractSpecifics,
+		priors::JointPriorPtr prior) {
+
+	using namespace priors;
+	ModelSpecifics<BaseModel,real>& specifics =
+			static_cast<ModelSpecifics<BaseModel,real>&>(abstractSpecifics);
+
+	if (const LaplacePrior* laplace =
+			StaticCyclicCoordinateDescent<BaseModel, LaplacePrior>::getCovariatePrior(prior)) {
+		return new StaticCyclicCoordinateDescent<BaseModel, LaplacePrior>(modelData, specifics,
+				prior, *laplace);
+	}
+	if (const NormalPrior* normal =
+			StaticCyclicCoordinateDescent<BaseModel, NormalPrior>::getCovariatePrior(prior)) {
+		return new StaticCyclicCoordinateDescent<BaseModel, NormalPrior>(modelData, specifics,
+				prior, *normal);
+	}
+	if (const NoPrior* none =
+			StaticCyclicCoordinateDescent<BaseModel, NoPrior>::getCovariatePrior(prior)) {
+		return new StaticCyclicCoordinateDescent<BaseModel, NoPrior>(modelData, specifics,
+				prior, *none);
+	}
+	return new CyclicCoordinateDescent(modelData, specifics, prior);
+}
+
+} // namespace
+
+#endif /* STATICCYCLICCOORDINATEDESCENT_H_ */
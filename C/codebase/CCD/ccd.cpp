@@ -37,6 +37,8 @@
 #include "io/NewCoxInputReader.h"
 #include "io/NewGenericInputReader.h"
 #include "io/BBRInputReader.h"
+#include "io/BinaryInputReader.h"
+#include "io/BinaryOutputWriter.h"
 #include "io/OutputWriter.h"
 #include "CrossValidationSelector.h"
 #include "GridSearchCrossValidationDriver.h"
@@ -44,7 +46,9 @@
 #include "BootstrapSelector.h"
 #include "ProportionSelector.h"
 #include "BootstrapDriver.h"
+#include "RegularizationPathDriver.h"
 #include "ModelSpecifics.h"
+#include "StaticCyclicCoordinateDescent.h"
 
 #include "tclap/CmdLine.h"
 #include "utils/RZeroIn.h"
@@ -59,6 +63,13 @@
 
 #define NEW
 
+#ifdef RUNTIME_PRECISION
+// Double-precision engine: the same sources, compiled with bsccs renamed to bsccs_dp
+namespace bsccs_dp {
+	int runCommandLine(int argc, char* argv[]);
+}
+#endif
+
 namespace bsccs {
 
 using namespace TCLAP;
@@ -147,11 +158,18 @@ void setDefaultArguments(CCDArguments &arguments) {
 	arguments.maxIterations = 1000;
 	arguments.inFileName = "default_in";
 	arguments.outFileName = "default_out";
+	arguments.binaryFileName = "";
+	arguments.collapseRows = false;
+	arguments.packIndices = false;
+	arguments.precision = (sizeof(real) == sizeof(double)) ? "double" : "float";
 	arguments.outDirectoryName = "";
 	arguments.hyperPriorSet = false;
 	arguments.hyperprior = 1.0;
 	arguments.tolerance = 1E-6; //5E-4;
 	arguments.seed = 123;
+	arguments.threads = 1;
+	arguments.crossTermCacheMB = AbstractModelSpecifics::defaultCrossTermCacheBytes >> 20;
+	arguments.rowMajorMB = CompressedDataMatrix::defaultRowMajorBudget >> 20;
 	arguments.doCrossValidation = false;
 	arguments.useAutoSearchCV = false;
 	arguments.lowerLimit = 0.01;
@@ -169,6 +187,9 @@ void setDefaultArguments(CCDArguments &arguments) {
 	arguments.fitMLEAtMode = false;
 	arguments.reportASE = false;
 	arguments.useNormalPrior = false;
+	arguments.useActiveSet = false;
+	arguments.usePath = false;
+	arguments.pathFileName = "path.txt";
 	arguments.convergenceType = GRADIENT;
 	arguments.convergenceTypeString = "gradient";
 	arguments.doPartial = false;
@@ -197,6 +218,7 @@ void parseCommandLine(std::vector<std::string>& args,
 		SwitchArg computeMLEArg("", "MLE", "Compute maximum likelihood estimates only", arguments.computeMLE);
 		SwitchArg computeMLEAtModeArg("", "MLEAtMode", "Compute maximum likelihood estimates at posterior mode", arguments.fitMLEAtMode);
 		SwitchArg reportASEArg("","ASE", "Compute asymptotic standard errors at posterior mode", arguments.reportASE);
+		SwitchArg activeSetArg("", "activeSet", "Screen covariates with strong rules; exact after KKT check", arguments.useActiveSet);
 
 		// Convergence criterion arguments
 		ValueArg<double> toleranceArg("t", "tolerance", "Convergence criterion tolerance", false, arguments.tolerance, "real");
@@ -210,6 +232,9 @@ void parseCommandLine(std::vector<std::string>& args,
 		ValueArg<string> convergenceArg("", "convergence", "Convergence criterion", false, arguments.convergenceTypeString, &allowedConvergenceValues);
 
 		ValueArg<long> seedArg("s", "seed", "Random number generator seed", false, arguments.seed, "long");
+		ValueArg<int> threadsArg("", "threads", "Number of worker threads for parsing, cross-validation, bootstrap, Cox risk-set scans and asymptotic variances", false, arguments.threads, "int");
+		ValueArg<int> crossTermCacheArg("", "crossTermCache", "Memory budget (MB) for per-stratum cross-terms in asymptotic variances", false, arguments.crossTermCacheMB, "int");
+		ValueArg<int> rowMajorArg("", "rowMajor", "Memory budget (MB) for a row-major copy of X used to form X*beta (0 = none)", false, arguments.rowMajorMB, "int");
 
 		// Cross-validation arguments
 		SwitchArg doCVArg("c", "cv", "Perform cross-validation selection of hyperprior variance", arguments.doCrossValidation);
@@ -221,6 +246,10 @@ void parseCommandLine(std::vector<std::string>& args,
 		ValueArg<int> foldToComputeCVArg("", "computeFold", "Number of fold to iterate, default is 'fold' value", false, 10, "int");
 		ValueArg<string> outFile2Arg("", "cvFileName", "Cross-validation output file name", false, arguments.cvFileName, "cvFileName");
 
+		// Regularization path arguments
+		SwitchArg pathArg("", "path", "Fit a warm-started path over the lower/upper/gridSize variances", arguments.usePath);
+		ValueArg<string> pathFileArg("", "pathFileName", "Regularization path output file name", false, arguments.pathFileName, "pathFileName");
+
 		// Bootstrap arguments
 		SwitchArg doBootstrapArg("b", "bs", "Perform bootstrap estimation", arguments.doBootstrap);
 //		ValueArg<string> bsOutFileArg("", "bsFileName", "Bootstrap output file name", false, "bs.txt", "bsFileName");
@@ -250,8 +279,17 @@ void parseCommandLine(std::vector<std::string>& args,
 		allowedFormats.push_back("new-cox");
 		allowedFormats.push_back("bbr");
 		allowedFormats.push_back("generic");
+		allowedFormats.push_back("binary");
 		ValuesConstraint<std::string> allowedFormatValues(allowedFormats);
 		ValueArg<string> formatArg("", "format", "Format of data file", false, arguments.fileFormat, &allowedFormatValues);
+		ValueArg<string> saveBinaryArg("", "saveBinary", "Save loaded data for later runs with '--format binary'", false, arguments.binaryFileName, "saveBinary");
+		SwitchArg collapseRowsArg("", "collapseRows", "Merge rows of a stratum with identical covariates (sccs model; predictions are per merged row)", arguments.collapseRows);
+		std::vector<std::string> allowedPrecisions;
+		allowedPrecisions.push_back("float");
+		allowedPrecisions.push_back("double");
+		ValuesConstraint<std::string> allowedPrecisionValues(allowedPrecisions);
+		ValueArg<string> precisionArg("", "precision", "Floating-point precision of the fit", false, arguments.precision, &allowedPrecisionValues);
+		SwitchArg packIndicesArg("", "packIndices", "Delta-encode long indicator columns to save memory bandwidth", arguments.packIndices);
 
 		// Output format arguments
 		std::vector<std::string> allowedOutputFormats;
@@ -278,15 +316,26 @@ void parseCommandLine(std::vector<std::string>& args,
 		cmd.add(computeMLEArg);
 		cmd.add(computeMLEAtModeArg);
 		cmd.add(reportASEArg);
+		cmd.add(activeSetArg);
 //		cmd.add(zhangOlesConvergenceArg);
 		cmd.add(convergenceArg);
 		cmd.add(seedArg);
+		cmd.add(threadsArg);
+		cmd.add(crossTermCacheArg);
+		cmd.add(rowMajorArg);
 		cmd.add(modelArg);
 		cmd.add(formatArg);
+		cmd.add(saveBinaryArg);
+		cmd.add(collapseRowsArg);
+		cmd.add(packIndicesArg);
+		cmd.add(precisionArg);
 		cmd.add(outputFormatArg);
 		cmd.add(profileCIArg);
 		cmd.add(flatPriorArg);
 
+		cmd.add(pathArg);
+		cmd.add(pathFileArg);
+
 		cmd.add(doCVArg);
 		cmd.add(useAutoSearchCVArg);
 		cmd.add(lowerCVArg);
@@ -328,10 +377,34 @@ void parseCommandLine(std::vector<std::string>& args,
 		arguments.computeMLE = computeMLEArg.getValue();
 		arguments.fitMLEAtMode = computeMLEAtModeArg.getValue();
 		arguments.reportASE = reportASEArg.getValue();
+		arguments.useActiveSet = activeSetArg.getValue();
 		arguments.seed = seedArg.getValue();
+		arguments.threads = threadsArg.getValue();
+		if (arguments.threads < 1) {
+			cerr << "Number of threads must be positive." << endl;
+			exit(-1);
+		}
+		arguments.crossTermCacheMB = crossTermCacheArg.getValue();
+		if (arguments.crossTermCacheMB < 0) {
+			cerr << "Cross-term cache budget must be non-negative." << endl;
+			exit(-1);
+		}
+		arguments.rowMajorMB = rowMajorArg.getValue();
+		if (arguments.rowMajorMB < 0) {
+			cerr << "Row-major budget must be non-negative." << endl;
+			exit(-1);
+		}
 
 		arguments.modelName = modelArg.getValue();
 		arguments.fileFormat = formatArg.getValue();
+		arguments.binaryFileName = saveBinaryArg.getValue();
+		arguments.collapseRows = collapseRowsArg.getValue();
+		if (arguments.collapseRows && arguments.modelName != "sccs") {
+			cerr << "Collapsing rows is only exact for the sccs model." << endl;
+			exit(-1);
+		}
+		arguments.packIndices = packIndicesArg.getValue();
+		arguments.precision = precisionArg.getValue();
 		arguments.outputFormat = outputFormatArg.getValue();
 		if (arguments.outputFormat.size() == 0) {
 			arguments.outputFormat.push_back("estimates");
@@ -365,6 +438,15 @@ void parseCommandLine(std::vector<std::string>& args,
 			exit(-1);
 		}
 
+		// Regularization path
+		arguments.usePath = pathArg.isSet();
+		if (arguments.usePath) {
+			arguments.lowerLimit = lowerCVArg.getValue();
+			arguments.upperLimit = upperCVArg.getValue();
+			arguments.gridSteps = gridCVArg.getValue();
+			arguments.pathFileName = pathFileArg.getValue();
+		}
+
 		// Cross-validation
 		arguments.doCrossValidation = doCVArg.isSet();
 		if (arguments.doCrossValidation) {
@@ -466,33 +548,68 @@ double initializeModel(
 		reader = new NewGenericInputReader(modelType);
 	} else if (arguments.fileFormat == "new-cox") {
 		reader = new NewCoxInputReader();
+	} else if (arguments.fileFormat == "binary") {
+		reader = new BinaryInputReader();
 	} else {
 		cerr << "Invalid file format." << endl;
 		exit(-1);
 	}
 
+	reader->setThreads(arguments.threads);
 	reader->readFile(arguments.inFileName.c_str()); // TODO Check for error
 	// delete reader;
 	*modelData = reader->getModelData();
 
+	if (arguments.binaryFileName != "") {
+		BinaryOutputWriter writer(**modelData);
+		writer.writeFile(arguments.binaryFileName.c_str());
+	}
+
+	if (arguments.collapseRows) {
+		ModelData* collapsed = (*modelData)->getCollapsedRows(arguments.threads);
+		if (collapsed) {
+			cout << "Number of rows after collapsing duplicates: "
+					<< collapsed->getNumberOfRows() << endl;
+			delete *modelData;
+			*modelData = collapsed;
+		} else {
+			cout << "No rows collapsed" << endl;
+		}
+	}
+
+	if (arguments.packIndices) {
+		(*modelData)->setPackedIndices(true);
+		(*modelData)->finalize(); // Re-encode the column arena
+	}
+
+	// Engine factory matching the model, chosen with it
+	CyclicCoordinateDescent* (*createEngine)(ModelData*, AbstractModelSpecifics&,
+			priors::JointPriorPtr) = NULL;
+
 	switch (modelType) {
 		case bsccs::Models::SELF_CONTROLLED_MODEL :
 			*model = new ModelSpecifics<SelfControlledCaseSeries<real>,real>(**modelData);
+			createEngine = &createCyclicCoordinateDescent<SelfControlledCaseSeries<real> >;
 			break;
 		case bsccs::Models::CONDITIONAL_LOGISTIC :
 			*model = new ModelSpecifics<ConditionalLogisticRegression<real>,real>(**modelData);
+			createEngine = &createCyclicCoordinateDescent<ConditionalLogisticRegression<real> >;
 			break;
 		case bsccs::Models::LOGISTIC :
 			*model = new ModelSpecifics<LogisticRegression<real>,real>(**modelData);
+			createEngine = &createCyclicCoordinateDescent<LogisticRegression<real> >;
 			break;
 		case bsccs::Models::NORMAL :
 			*model = new ModelSpecifics<LeastSquares<real>,real>(**modelData);
+			createEngine = &createCyclicCoordinateDescent<LeastSquares<real> >;
 			break;
 		case bsccs::Models::POISSON :
 			*model = new ModelSpecifics<PoissonRegression<real>,real>(**modelData);
+			createEngine = &createCyclicCoordinateDescent<PoissonRegression<real> >;
 			break;
 		case bsccs::Models::COX :
 			*model = new ModelSpecifics<CoxProportionalHazards<real>,real>(**modelData);
+			createEngine = &createCyclicCoordinateDescent<CoxProportionalHazards<real> >;
 			break;
 		default:
 			cerr << "Invalid model type." << endl;
@@ -501,6 +618,13 @@ double initializeModel(
 
 #ifdef CUDA
 	if (arguments.useGPU) {
+		// Device kernels read indicator columns as row lists
+		for (int j = 0; j < (*modelData)->getNumberOfColumns(); ++j) {
+			if ((*modelData)->getFormatType(j) == BITMAP ||
+					(*modelData)->getFormatType(j) == PACKED) {
+				(*modelData)->convertColumnToIndicator(j);
+			}
+		}
 		*ccd = new GPUCyclicCoordinateDescent(arguments.deviceNumber, *reader, **model);
 	} else {
 #endif
@@ -542,13 +666,18 @@ double initializeModel(
 		prior = mixturePrior;
 	}
 
-	*ccd = new CyclicCoordinateDescent(*modelData /* TODO Change to ref */, **model, prior);
+	(*model)->setThreads(arguments.threads); // Before the engine builds its column lists
+	*ccd = createEngine(*modelData /* TODO Change to ref */, **model, prior);
 
 #ifdef CUDA
 	}
 #endif
 
 	(*ccd)->setNoiseLevel(arguments.noiseLevel);
+	(*ccd)->setUseActiveSet(arguments.useActiveSet);
+	(*ccd)->setThreads(arguments.threads);
+	(*model)->setCrossTermCacheBudget(static_cast<size_t>(arguments.crossTermCacheMB) << 20);
+	(*modelData)->setRowMajorBudget(static_cast<size_t>(arguments.rowMajorMB) << 20);
 
 	gettimeofday(&time2, NULL);
 	double sec1 = calculateSeconds(time1, time2);
@@ -727,6 +856,21 @@ double runBoostrap(
 }
 
 
+double runRegularizationPath(CyclicCoordinateDescent *ccd, ModelData *modelData,
+		CCDArguments &arguments) {
+	struct timeval time1, time2;
+	gettimeofday(&time1, NULL);
+
+	RegularizationPathDriver driver(arguments.gridSteps, arguments.lowerLimit,
+			arguments.upperLimit, modelData);
+
+	driver.drive(*ccd, arguments);
+	gettimeofday(&time2, NULL);
+
+	driver.logResults(arguments);
+	return calculateSeconds(time1, time2);
+}
+
 double runFitMLEAtMode(CyclicCoordinateDescent* ccd, CCDArguments &arguments) {
 	std::cout << std::endl << "Estimating MLE at posterior mode" << std::endl;
 
@@ -821,11 +965,7 @@ bool includesOption(const string& line, const string& option) {
 	return found != string::npos;
 }
 
-} // namespace
-
-int main(int argc, char* argv[]) {
-
-	using namespace bsccs;
+int runCommandLine(int argc, char* argv[]) {
 
 	CyclicCoordinateDescent* ccd = NULL;
 	AbstractModelSpecifics* model = NULL;
@@ -834,11 +974,25 @@ int main(int argc, char* argv[]) {
 
 	parseCommandLine(argc, argv, arguments);
 
+	if (arguments.precision != ((sizeof(real) == sizeof(double)) ? "double" : "float")) {
+#ifdef RUNTIME_PRECISION
+		return bsccs_dp::runCommandLine(argc, argv);
+#else
+		cerr << "Precision " << arguments.precision << " is not available in this build." << endl;
+		exit(-1);
+#endif
+	}
+
 	double timeInitialize = initializeModel(&modelData, &ccd, &model, arguments);
 
 	double timeUpdate;
 	if (arguments.doCrossValidation) {
 		timeUpdate = runCrossValidation(ccd, modelData, arguments);
+	} else if (arguments.usePath) {
+		timeUpdate = runRegularizationPath(ccd, modelData, arguments);
+		if (arguments.fitMLEAtMode) {
+			timeUpdate += runFitMLEAtMode(ccd, arguments);
+		}
 	} else {
 		if (arguments.doPartial) {
 			ProportionSelector selector(arguments.replicates, modelData->getPidVectorSTL(),
@@ -920,4 +1074,12 @@ int main(int argc, char* argv[]) {
     return 0;
 }
 
+} // namespace
+
+#ifndef NO_MAIN
+int main(int argc, char* argv[]) {
+	return bsccs::runCommandLine(argc, argv);
+}
+#endif
+
 #endif
@@ -33,6 +33,10 @@ struct CCDArguments {
 	std::string inFileName;
 	std::string outFileName;
 	std::string fileFormat;
+	std::string binaryFileName;
+	bool collapseRows;
+	bool packIndices;
+	std::string precision;
 	std::string outDirectoryName;
 	std::vector<std::string> outputFormat;
 	bool useGPU;
@@ -45,10 +49,16 @@ struct CCDArguments {
 	bool reportASE;
 	bool useNormalPrior;
 	bool hyperPriorSet;
+	bool useActiveSet;
+	bool usePath;
+	std::string pathFileName;
 	int maxIterations;
 	std::string convergenceTypeString;
 	int convergenceType;
 	long seed;
+	int threads;
+	int crossTermCacheMB;
+	int rowMajorMB;
 
 	// Needed for cross-validation
 	bool doCrossValidation;
@@ -89,6 +99,11 @@ void parseCommandLine(
 		std::vector<std::string>& argcpp,
 		CCDArguments& arguments);
 
+// Runs ccd on the command line; returns the exit status
+int runCommandLine(
+		int argc,
+		char* argv[]);
+
 double initializeModel(
 		ModelData** modelData,
 		CyclicCoordinateDescent** ccd,
@@ -120,6 +135,11 @@ double runBoostrap(
 		ModelData *modelData,
 		CCDArguments &arguments);
 
+double runRegularizationPath(
+		CyclicCoordinateDescent *ccd,
+		ModelData *modelData,
+		CCDArguments &arguments);
+
 double calculateSeconds(
 		const struct timeval &time1,
 		const struct timeval &time2);
@@ -88,6 +88,12 @@ void ImputeVariables::initialize(CCDArguments args, int numberOfImputations, boo
 		cerr << "Invalid file format." << endl;
 		exit(-1);
 	}
+	// Imputation edits indicator columns row by row, so unpack any encoded ones
+	for (int j = 0; j < modelData->getNumberOfColumns(); ++j) {
+		if (modelData->getFormatType(j) == BITMAP || modelData->getFormatType(j) == PACKED) {
+			modelData->convertColumnToIndicator(j);
+		}
+	}
 	imputeHelper->saveOrigYVector(modelData->getYVector(), modelData->getNumberOfRows());
 	srand(time(NULL));
 }
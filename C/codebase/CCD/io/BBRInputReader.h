@@ -177,6 +177,7 @@ public:
 		modelData->nPatients = numCases;
 		modelData->nRows = currentRow;
 		modelData->conditionId = "0";
+		modelData->finalize();
 		
 		
 		cerr << "Total 0: " << modelData->getColumn(0).sumColumn(currentRow) << endl;
@@ -9,9 +9,12 @@
 #define GENERICSPARSEREADER_H_
 
 #include <vector>
+#include <cstring>
+#include <thread>
 
 #include "InputReader.h"
 #include "SparseIndexer.h"
+#include "RowTokenizer.h"
  
 #define MAX_ENTRIES		1000000000
 #define MISSING_STRING	"NA"
@@ -26,16 +29,17 @@ struct RowInformation {
 	int currentRow;
 	int numCases;
 	int numEvents;
+	int leadingEvents;
 	string outcomeId;
 	string currentPid;
+	string firstPid;
 	SparseIndexer indexer;
-	string_vector scratch;
 
 	RowInformation(int _currentRow, int _numCases, int _numEvents,
 			string _outcomeId, string _currentPid,
 			SparseIndexer _indexer) : currentRow(_currentRow), numCases(_numCases),
-			numEvents(_numEvents), outcomeId(_outcomeId), currentPid(_currentPid),
-			indexer(_indexer) {
+			numEvents(_numEvents), leadingEvents(0), outcomeId(_outcomeId), currentPid(_currentPid),
+			firstPid(_currentPid), indexer(_indexer) {
 		// Do nothing
 	}
 };
@@ -70,7 +74,7 @@ public:
 	}
 
 	virtual void readFile(const char* fileName) {
-		ifstream in(fileName);
+		ifstream in(fileName, std::ios::in | std::ios::binary);
 		if (!in) {
 			cerr << "Unable to open " << fileName << endl;
 			exit(-1);
@@ -78,27 +82,52 @@ public:
 
 		// Initial values
 		RowInformation rowInfo(0,0,0, MISSING_STRING, MISSING_STRING, *modelData);
-		string line;
+		std::vector<char> text;
 
 		try {
 			static_cast<DerivedFormat*>(this)->parseHeader(in);
 
 			static_cast<DerivedFormat*>(this)->addFixedCovariateColumns();
 
-			while (getline(in, line) && (rowInfo.currentRow < MAX_ENTRIES)) {
-				if (!line.empty()) {
-					stringstream ss(line.c_str()); // Tokenize
-					static_cast<DerivedFormat*>(this)->parseRow(ss, rowInfo);
-					rowInfo.currentRow++;
-				}
-			}
-			addEventEntry(rowInfo.numEvents); // Save last patient
-
+			readRemainder(in, text);
 		} catch (...) {
 			cerr << "Exception while trying to read " << fileName << endl;
 			exit(-1);
 		}
-		
+
+		std::vector<const char*> bounds = splitIntoChunks(text);
+		const int nChunks = bounds.size() - 1;
+
+		if (nChunks == 1) {
+			parseChunk(bounds[0], bounds[1], rowInfo);
+		} else {
+			// Each chunk is parsed by a copy of this reader into its own ModelData
+			std::vector<DerivedFormat*> chunkReaders;
+			std::vector<RowInformation> chunkInfo;
+			for (int k = 0; k < nChunks; ++k) {
+				chunkReaders.push_back(new DerivedFormat(*static_cast<DerivedFormat*>(this)));
+				chunkReaders[k]->addFixedCovariateColumns();
+				chunkInfo.push_back(RowInformation(0,0,0, MISSING_STRING, MISSING_STRING,
+						*chunkReaders[k]->modelData));
+			}
+
+			std::vector<std::thread> workers;
+			for (int k = 0; k < nChunks; ++k) {
+				workers.push_back(std::thread(&BaseInputReader::parseChunk, chunkReaders[k],
+						bounds[k], bounds[k + 1], std::ref(chunkInfo[k])));
+			}
+			for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+				it->join();
+			}
+
+			const int nFixed = modelData->getNumberOfColumns();
+			for (int k = 0; k < nChunks; ++k) {
+				mergeChunk(*chunkReaders[k]->modelData, chunkInfo[k], nFixed, rowInfo);
+				delete chunkReaders[k];
+			}
+		}
+		addEventEntry(rowInfo.numEvents); // Save last patient
+
 		static_cast<DerivedFormat*>(this)->upcastColumns(modelData, rowInfo);
 
 		doSort(); // Override for sort criterion or no sorting
@@ -110,32 +139,221 @@ public:
 		modelData->nPatients = rowInfo.numCases;
 		modelData->nRows = rowInfo.currentRow;
 		modelData->conditionId = rowInfo.outcomeId;
+
+		modelData->finalize();
 	}	 
 	
 protected:
+	static const size_t minimumChunkSize = 1 << 20;
+
+	// Reads everything after the header into memory, terminated by '\0'
+	void readRemainder(ifstream& in, std::vector<char>& text) {
+		if (!in.good()) {
+			text.assign(1, '\0');
+			return;
+		}
+		const std::streampos start = in.tellg();
+		in.seekg(0, std::ios::end);
+		const size_t length = static_cast<size_t>(in.tellg() - start);
+		in.seekg(start);
+		text.resize(length + 1);
+		in.read(text.data(), length);
+		text[length] = '\0';
+	}
+
+	// Splits the text into at most nThreads ranges that begin on the first row of a stratum
+	std::vector<const char*> splitIntoChunks(const std::vector<char>& text) {
+		const char* begin = text.data();
+		const char* end = begin + text.size() - 1;
+		const size_t length = end - begin;
+		const int nChunks = static_cast<int>(std::max(static_cast<size_t>(1),
+				std::min(static_cast<size_t>(nThreads), length / minimumChunkSize)));
+		const int stratumColumn = static_cast<DerivedFormat*>(this)->getStratumColumn();
+
+		std::vector<const char*> bounds(1, begin);
+		for (int k = 1; k < nChunks; ++k) {
+			const char* bound = std::max(bounds.back(), begin + (length / nChunks) * k);
+			bound = findNextRow(bound, end);
+			if (stratumColumn >= 0) {
+				bound = findNextStratum(bound, end, stratumColumn);
+			}
+			if (bound != bounds.back() && bound != end) {
+				bounds.push_back(bound);
+			}
+		}
+		bounds.push_back(end);
+		return bounds;
+	}
+
+	// Start of the row after the one holding position
+	static const char* findNextRow(const char* position, const char* end) {
+		const char* newline = static_cast<const char*>(memchr(position, '\n', end - position));
+		return (newline == NULL) ? end : newline + 1;
+	}
+
+	// Start of the first row after row whose stratum label differs; rows without one are skipped
+	static const char* findNextStratum(const char* row, const char* end, int column) {
+		string current;
+		for (; row < end; row = findNextRow(row, end)) {
+			const char* newline = static_cast<const char*>(memchr(row, '\n', end - row));
+			RowTokenizer ss(row, (newline == NULL) ? end : newline);
+			const char* label;
+			const char* labelEnd;
+			bool found = true;
+			for (int i = 0; i <= column && found; ++i) {
+				found = ss.nextToken(label, labelEnd);
+			}
+			if (!found) {
+				continue;
+			}
+			if (current.empty()) {
+				current.assign(label, labelEnd - label);
+			} else if (current.compare(0, string::npos, label, labelEnd - label) != 0) {
+				return row;
+			}
+		}
+		return end;
+	}
+
+	void parseChunk(const char* begin, const char* end, RowInformation& rowInfo) {
+		try {
+			const char* line = begin;
+			while (line < end && (rowInfo.currentRow < MAX_ENTRIES)) {
+				const char* newline = static_cast<const char*>(memchr(line, '\n', end - line));
+				const char* lineEnd = (newline == NULL) ? end : newline;
+				if (lineEnd != line) {
+					RowTokenizer ss(line, lineEnd); // Tokenize
+					static_cast<DerivedFormat*>(this)->parseRow(ss, rowInfo);
+					rowInfo.currentRow++;
+				}
+				line = lineEnd + 1;
+			}
+		} catch (...) {
+			cerr << "Exception while trying to parse input rows" << endl;
+			exit(-1);
+		}
+	}
+
+	/**
+	 * Appends the rows parsed from one chunk, in file order, so the result matches parsing all
+	 * rows serially.  Chunks begin on a new stratum, but events parsed in a row ahead of its
+	 * stratum label count towards the previous stratum, as they do when parsed serially.
+	 */
+	void mergeChunk(const ModelData& chunk, const RowInformation& chunkInfo, int nFixed,
+			RowInformation& rowInfo) {
+		if (chunkInfo.currentRow == 0) {
+			return;
+		}
+
+		if (chunkInfo.outcomeId != MISSING_STRING) {
+			if (rowInfo.outcomeId == MISSING_STRING) {
+				rowInfo.outcomeId = chunkInfo.outcomeId;
+			} else if (chunkInfo.outcomeId != rowInfo.outcomeId) {
+				cerr << "More than one condition ID in input file" << endl;
+				exit(-1);
+			}
+		}
+
+		for (std::vector<int>::const_iterator it = chunk.pid.begin(); it != chunk.pid.end(); ++it) {
+			modelData->pid.push_back(*it + rowInfo.numCases);
+		}
+
+		std::vector<int>::const_iterator event = chunk.nevents.begin();
+		if (chunkInfo.firstPid == MISSING_STRING) { // No strata
+			rowInfo.numEvents += chunkInfo.numEvents;
+		} else {
+			if (rowInfo.currentPid != MISSING_STRING) {
+				addEventEntry(rowInfo.numEvents + chunkInfo.leadingEvents);
+				if (event != chunk.nevents.end()) {
+					addEventEntry(*event - chunkInfo.leadingEvents);
+					++event;
+					rowInfo.numEvents = chunkInfo.numEvents;
+				} else {
+					rowInfo.numEvents = chunkInfo.numEvents - chunkInfo.leadingEvents;
+				}
+			} else {
+				rowInfo.numEvents = chunkInfo.numEvents;
+			}
+			rowInfo.currentPid = chunkInfo.currentPid;
+		}
+		modelData->nevents.insert(modelData->nevents.end(), event, chunk.nevents.end());
+		rowInfo.numCases += chunkInfo.numCases;
+
+		modelData->y.insert(modelData->y.end(), chunk.y.begin(), chunk.y.end());
+		modelData->z.insert(modelData->z.end(), chunk.z.begin(), chunk.z.end());
+		modelData->offs.insert(modelData->offs.end(), chunk.offs.begin(), chunk.offs.end());
+		modelData->labels.insert(modelData->labels.end(), chunk.labels.begin(), chunk.labels.end());
+
+		// Fixed covariates keep their position; others are matched on label in order of appearance
+		for (int j = 0; j < chunk.getNumberOfColumns(); ++j) {
+			const CompressedDataColumn& source = chunk.getColumn(j);
+			if (j < nFixed) {
+				appendColumn(modelData->getColumn(j), source, rowInfo.currentRow);
+			} else {
+				const DrugIdType drug = source.getNumericalLabel();
+				if (!rowInfo.indexer.hasColumn(drug)) {
+					rowInfo.indexer.addColumn(drug, source.getFormatType());
+				}
+				appendColumn(rowInfo.indexer.getColumn(drug), source, rowInfo.currentRow);
+			}
+		}
+
+		rowInfo.currentRow += chunkInfo.currentRow;
+	}
+
+	void appendColumn(CompressedDataColumn& column, const CompressedDataColumn& source, int rowOffset) {
+		const FormatType formatType = source.getFormatType();
+		if (formatType == DENSE) {
+			const real* values = source.getData();
+			const int n = source.getDataVectorLength();
+			for (int i = 0; i < n; ++i) {
+				column.add_data(rowOffset + i, values[i]);
+			}
+		} else if (formatType == SPARSE || formatType == INDICATOR) {
+			if (formatType == SPARSE && column.getFormatType() == INDICATOR) {
+				column.convertColumnToSparse();
+			}
+			const int* rows = source.getColumns();
+			const int n = source.getNumberOfEntries();
+			for (int i = 0; i < n; ++i) {
+				column.add_data(rowOffset + rows[i],
+						formatType == SPARSE ? source.getData()[i] : static_cast<real>(1));
+			}
+		}
+	}
+
 	void parseHeader(ifstream& in) {
 		string line;
 		getline(in, line); // Read header
 	}
+
+	// Token holding the stratum label of each row, or -1 when rows are not grouped in strata
+	int getStratumColumn() const {
+		return -1;
+	}
 	
 	void upcastColumns(ModelData* modelData, RowInformation& rowInfo) {
 		// Do nothing
 	}
 
-	void parseAllBBRCovariatesEntry(stringstream& ss, RowInformation& rowInfo, bool indicatorOnly) {
-		string entry;
-		int count = 0;
-		while (ss >> entry) {
-			rowInfo.scratch.clear();
+	void parseAllBBRCovariatesEntry(RowTokenizer& ss, RowInformation& rowInfo, bool indicatorOnly) {
+		const char* entry;
+		const char* entryEnd;
+		while (ss.nextToken(entry, entryEnd)) {
 			DrugIdType drug;
 			real value;
 			if (indicatorOnly) {
-				drug = atoi(entry.c_str());
+				drug = RowTokenizer::parseInt(entry, entryEnd);
 				value = static_cast<real>(1);
 			} else {
-				split(rowInfo.scratch, entry, getInnerDelimitor());
-				drug = atoi(rowInfo.scratch[0].c_str());
-				value = atof(rowInfo.scratch[1].c_str());
+				const char* delimitor = std::search(entry, entryEnd,
+						getInnerDelimitor().begin(), getInnerDelimitor().end());
+				if (delimitor == entryEnd) {
+					cerr << "Missing value for covariate in data row: " << (rowInfo.currentRow + 1) << endl;
+					exit(-1);
+				}
+				drug = RowTokenizer::parseInt(entry, delimitor);
+				value = atof(delimitor + getInnerDelimitor().size());
 			}
 			if (!rowInfo.indexer.hasColumn(drug)) {
 				// Add new column
@@ -175,46 +393,53 @@ protected:
 		// Do nothing
 	}
 
-	void parseConditionEntry(stringstream& ss,
+	void parseConditionEntry(RowTokenizer& ss,
 			RowInformation& rowInfo) {
-		string currentOutcomeId;
-		ss >> currentOutcomeId;
+		const char* currentOutcomeId;
+		const char* currentOutcomeIdEnd;
+		ss.nextToken(currentOutcomeId, currentOutcomeIdEnd);
+		const size_t length = currentOutcomeIdEnd - currentOutcomeId;
 		if (rowInfo.outcomeId == MISSING_STRING) {
-			rowInfo.outcomeId = currentOutcomeId;
-		} else if (currentOutcomeId != rowInfo.outcomeId) {
+			rowInfo.outcomeId.assign(currentOutcomeId, length);
+		} else if (rowInfo.outcomeId.compare(0, string::npos, currentOutcomeId, length) != 0) {
 			cerr << "More than one condition ID in input file" << endl;
 			exit(-1);
 		}
 	}
 
-	void parseNoStratumEntry(stringstream& ss, RowInformation& rowInfo) {
+	void parseNoStratumEntry(RowTokenizer& ss, RowInformation& rowInfo) {
 		addEventEntry(1);
 		modelData->pid.push_back(rowInfo.numCases);
 		rowInfo.numCases++;
 	}
 
-	void parseRowLabel(stringstream& ss, RowInformation& rowInfo) {
+	void parseRowLabel(RowTokenizer& ss, RowInformation& rowInfo) {
 		string label;
 		ss >> label;
 		modelData->labels.push_back(label);
 	}
 
-	void parseStratumEntry(stringstream& ss, RowInformation& rowInfo) {
-		string unmappedPid;
-		ss >> unmappedPid;
-		if (unmappedPid != rowInfo.currentPid) { // New patient, ASSUMES these are sorted
+	void parseStratumEntry(RowTokenizer& ss, RowInformation& rowInfo) {
+		const char* unmappedPid;
+		const char* unmappedPidEnd;
+		ss.nextToken(unmappedPid, unmappedPidEnd);
+		const size_t length = unmappedPidEnd - unmappedPid;
+		if (rowInfo.currentPid.compare(0, string::npos, unmappedPid, length) != 0) { // New patient, ASSUMES these are sorted
 			if (rowInfo.currentPid != MISSING_STRING) { // Skip first switch
 				addEventEntry(rowInfo.numEvents);
 				rowInfo.numEvents = 0;
+			} else {
+				rowInfo.firstPid.assign(unmappedPid, length);
+				rowInfo.leadingEvents = rowInfo.numEvents;
 			}
-			rowInfo.currentPid = unmappedPid;
+			rowInfo.currentPid.assign(unmappedPid, length);
 			rowInfo.numCases++;
 		}
 		modelData->pid.push_back(rowInfo.numCases - 1);
 	}
 
 	template <typename T>
-	void parseSingleOutcomeEntry(stringstream& ss, RowInformation& rowInfo) {
+	void parseSingleOutcomeEntry(RowTokenizer& ss, RowInformation& rowInfo) {
 		T thisY;
 		ss >> thisY;
 		rowInfo.numEvents += thisY;
@@ -222,14 +447,14 @@ protected:
 	}
 	
 	template <typename T>
-	void parseSingleTimeEntry(stringstream& ss, RowInformation& rowInfo) {
+	void parseSingleTimeEntry(RowTokenizer& ss, RowInformation& rowInfo) {
 		T thisY;
 		ss >> thisY;		
 		modelData->z.push_back(thisY);
 	}	
 
 	template <typename T>
-	void parseSingleBBROutcomeEntry(stringstream& ss, RowInformation& rowInfo) {
+	void parseSingleBBROutcomeEntry(RowTokenizer& ss, RowInformation& rowInfo) {
 		T thisY;
 		ss >> thisY;
 		if (thisY < static_cast<T>(0)) { // BBR uses +1 / -1, BSCCS uses 1 / 0.
@@ -239,7 +464,7 @@ protected:
 		modelData->y.push_back(thisY);
 	}
 
-	void parseOffsetCovariateEntry(stringstream& ss, RowInformation& rowInfo, bool inLogSpace) {
+	void parseOffsetCovariateEntry(RowTokenizer& ss, RowInformation& rowInfo, bool inLogSpace) {
 		real thisOffset;
 		ss >> thisOffset;
 		if (!inLogSpace) {
@@ -248,13 +473,13 @@ protected:
 		modelData->getColumn(0).add_data(rowInfo.currentRow, thisOffset);
 	}
 
-	void parseOffsetEntry(stringstream& ss, RowInformation&) {
+	void parseOffsetEntry(RowTokenizer& ss, RowInformation&) {
 		real thisOffs;
 		ss >> thisOffs;
 		modelData->offs.push_back(thisOffs);
 	}
 
-	void parseAllIndicatorCovariatesEntry(stringstream& ss, RowInformation& rowInfo) {
+	void parseAllIndicatorCovariatesEntry(RowTokenizer& ss, RowInformation& rowInfo) {
 		DrugIdType drug;
 		while (ss >> drug) {
 			if (drug == 0) { // No drug
@@ -0,0 +1,77 @@
+/*
+ * BinaryFormat.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef BINARYFORMAT_H_
+#define BINARYFORMAT_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace bsccs {
+
+/*
+ * On-disk layout of a fully loaded ModelData.  Sections follow the header in this order,
+ * each starting on an 8-byte boundary so that they can be used in place from a mapping:
+ *
+ * 	conditionId (char), pid (int), y, z, offs (real), nevents (int),
+ * 	row label lengths (int64_t) and bytes (char),
+ * 	column table (BinaryColumn), column label bytes (char),
+ * 	index arena (int), data arena (real)
+ *
+ * The index and data arenas are the CSC arrays built by CompressedDataMatrix::finalize();
+ * BITMAP and PACKED columns keep their encoded words in the index arena.
+ */
+namespace BinaryFormat {
+
+	const char magic[8] = { 'B', 'S', 'C', 'C', 'S', 'B', 'I', 'N' };
+	const int32_t version = 1;
+	const int32_t byteOrder = 0x01020304;
+
+	struct Header {
+		char magic[8];
+		int32_t version;
+		int32_t byteOrder;
+		int32_t realSize;
+		int32_t hasOffsetCovariate;
+		int32_t hasInterceptCovariate;
+		int32_t padding;
+		int64_t nRows;
+		int64_t nCols;
+		int64_t nPatients;
+		int64_t nEntries;
+		int64_t conditionIdLength;
+		int64_t pidLength;
+		int64_t yLength;
+		int64_t zLength;
+		int64_t offsLength;
+		int64_t neventsLength;
+		int64_t nLabels;
+		int64_t labelBytes;
+		int64_t columnLabelBytes;
+		int64_t indexLength;
+		int64_t dataLength;
+	};
+
+	struct Column {
+		int32_t formatType;
+		int32_t numericalName;
+		int64_t indexOffset;
+		int64_t nIndices;
+		int64_t dataOffset;
+		int64_t nValues;
+		int64_t labelLength;
+	};
+
+	inline size_t align(size_t bytes) {
+		return (bytes + 7) & ~static_cast<size_t>(7);
+	}
+
+} // namespace BinaryFormat
+
+} // namespace
+
+#endif /* BINARYFORMAT_H_ */
@@ -0,0 +1,208 @@
+/*
+ * BinaryInputReader.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "BinaryInputReader.h"
+
+namespace bsccs {
+
+using namespace std;
+
+namespace {
+
+#ifdef _WIN32
+struct BufferRelease {
+	void operator()(void* buffer) {
+		free(buffer);
+	}
+};
+#else
+struct MappingRelease {
+	size_t length;
+
+	MappingRelease(size_t _length) : length(_length) {
+		// Do nothing
+	}
+
+	void operator()(void* region) {
+		munmap(region, length);
+	}
+};
+#endif
+
+// Reads consecutive 8-byte aligned sections from the mapped file
+class SectionCursor {
+public:
+	SectionCursor(char* _begin, size_t _length, const char* _fileName) :
+		begin(_begin), length(_length), offset(0), fileName(_fileName) {
+		// Do nothing
+	}
+
+	template <typename T>
+	T* next(int64_t count) {
+		const size_t bytes = static_cast<size_t>(count) * sizeof(T);
+		if (count < 0 || offset + bytes > length) {
+			cerr << "Truncated binary file " << fileName << endl;
+			exit(-1);
+		}
+		T* section = reinterpret_cast<T*>(begin + offset);
+		offset += BinaryFormat::align(bytes);
+		return section;
+	}
+
+private:
+	char* begin;
+	size_t length;
+	size_t offset;
+	const char* fileName;
+};
+
+} // namespace
+
+BinaryInputReader::BinaryInputReader() : InputReader() {
+	// Do nothing
+}
+
+BinaryInputReader::~BinaryInputReader() {
+	// Do nothing
+}
+
+void BinaryInputReader::readFile(const char* fileName) {
+
+	char* region = NULL;
+	size_t length = 0;
+
+#ifdef _WIN32
+	FILE* file = fopen(fileName, "rb");
+	if (file == NULL) {
+		cerr << "Unable to open binary file " << fileName << endl;
+		exit(-1);
+	}
+	fseek(file, 0, SEEK_END);
+	length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	region = static_cast<char*>(malloc(length > 0 ? length : 1));
+	if (fread(region, 1, length, file) != length) {
+		cerr << "Unable to read binary file " << fileName << endl;
+		exit(-1);
+	}
+	fclose(file);
+	modelData->mappedArena = std::shared_ptr<void>(region, BufferRelease());
+#else
+	int fd = open(fileName, O_RDONLY);
+	struct stat status;
+	if (fd < 0 || fstat(fd, &status) != 0) {
+		cerr << "Unable to open binary file " << fileName << endl;
+		exit(-1);
+	}
+	length = status.st_size;
+	// Private, writable pages so that any in-place change stays out of the file
+	void* mapping = length > 0 ?
+			mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		cerr << "Unable to map binary file " << fileName << endl;
+		exit(-1);
+	}
+	region = static_cast<char*>(mapping);
+	modelData->mappedArena = std::shared_ptr<void>(mapping, MappingRelease(length));
+#endif
+
+	SectionCursor cursor(region, length, fileName);
+	const BinaryFormat::Header& header = *cursor.next<BinaryFormat::Header>(1);
+
+	if (memcmp(header.magic, BinaryFormat::magic, sizeof(header.magic)) != 0) {
+		cerr << fileName << " is not a binary data file" << endl;
+		exit(-1);
+	}
+	if (header.version != BinaryFormat::version || header.byteOrder != BinaryFormat::byteOrder) {
+		cerr << "Unsupported version or byte order in binary file " << fileName << endl;
+		exit(-1);
+	}
+	if (header.realSize != sizeof(real)) {
+		cerr << "Binary file " << fileName << " was saved with " << (8 * header.realSize)
+			 << "-bit reals; this build uses " << (8 * sizeof(real)) << "-bit reals" << endl;
+		exit(-1);
+	}
+
+	const char* conditionId = cursor.next<char>(header.conditionIdLength);
+	const int* pid = cursor.next<int>(header.pidLength);
+	const real* y = cursor.next<real>(header.yLength);
+	const real* z = cursor.next<real>(header.zLength);
+	const real* offs = cursor.next<real>(header.offsLength);
+	const int* nevents = cursor.next<int>(header.neventsLength);
+	const int64_t* labelLengths = cursor.next<int64_t>(header.nLabels);
+	const char* labels = cursor.next<char>(header.labelBytes);
+	const BinaryFormat::Column* table = cursor.next<BinaryFormat::Column>(header.nCols);
+	const char* columnLabels = cursor.next<char>(header.columnLabelBytes);
+	int* indexArena = cursor.next<int>(header.indexLength);
+	real* dataArena = cursor.next<real>(header.dataLength);
+
+	modelData->conditionId.assign(conditionId, header.conditionIdLength);
+	modelData->pid.assign(pid, pid + header.pidLength);
+	modelData->y.assign(y, y + header.yLength);
+	modelData->z.assign(z, z + header.zLength);
+	modelData->offs.assign(offs, offs + header.offsLength);
+	modelData->nevents.assign(nevents, nevents + header.neventsLength);
+
+	modelData->labels.resize(header.nLabels);
+	for (int64_t i = 0; i < header.nLabels; ++i) {
+		modelData->labels[i].assign(labels, labelLengths[i]);
+		labels += labelLengths[i];
+	}
+
+	// Columns view their entries in the mapping
+	for (int64_t j = 0; j < header.nCols; ++j) {
+		const BinaryFormat::Column& entry = table[j];
+		if (entry.indexOffset + entry.nIndices > header.indexLength ||
+				entry.dataOffset + entry.nValues > header.dataLength) {
+			cerr << "Corrupt column table in binary file " << fileName << endl;
+			exit(-1);
+		}
+		const FormatType formatType = static_cast<FormatType>(entry.formatType);
+		modelData->push_back(formatType);
+		CompressedDataColumn& column = modelData->getColumn(j);
+		column.add_label(static_cast<DrugIdType>(entry.numericalName));
+		column.add_label(std::string(columnLabels, entry.labelLength));
+		columnLabels += entry.labelLength;
+
+		const bool hasIndices = formatType == SPARSE || formatType == INDICATOR ||
+				formatType == BITMAP || formatType == PACKED;
+		const bool hasValues = formatType == SPARSE || formatType == DENSE;
+		column.attachToArena(
+				hasIndices ? indexArena + entry.indexOffset : NULL, entry.nIndices,
+				hasValues ? dataArena + entry.dataOffset : NULL, entry.nValues);
+	}
+
+	modelData->hasOffsetCovariate = header.hasOffsetCovariate;
+	modelData->hasInterceptCovariate = header.hasInterceptCovariate;
+	modelData->nPatients = header.nPatients;
+	modelData->nRows = header.nRows;
+	modelData->nEntries = header.nEntries;
+
+#ifndef MY_RCPP_FLAG
+	cout << "Number of rows: " << modelData->nRows << " read from " << fileName << endl;
+	cout << "Number of cases: " << modelData->nPatients << endl;
+	cout << "Number of covariates: " << modelData->getNumberOfColumns() << endl;
+#endif
+}
+
+} // namespace
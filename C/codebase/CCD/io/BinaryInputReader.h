@@ -0,0 +1,31 @@
+/*
+ * BinaryInputReader.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef BINARYINPUTREADER_H_
+#define BINARYINPUTREADER_H_
+
+#include "InputReader.h"
+#include "BinaryFormat.h"
+
+namespace bsccs {
+
+/*
+ * Opens a file saved by BinaryOutputWriter.  The file is memory-mapped and column entries
+ * are used in place as the CompressedDataMatrix arena, so no parsing or copying of the CSC
+ * arrays takes place; the mapping lives as long as the ModelData.
+ */
+class BinaryInputReader : public InputReader {
+public:
+	BinaryInputReader();
+	virtual ~BinaryInputReader();
+
+	virtual void readFile(const char* fileName);
+};
+
+} // namespace
+
+#endif /* BINARYINPUTREADER_H_ */
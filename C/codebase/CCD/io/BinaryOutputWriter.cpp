@@ -0,0 +1,132 @@
+/*
+ * BinaryOutputWriter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "BinaryOutputWriter.h"
+
+namespace bsccs {
+
+using namespace std;
+
+void BinaryOutputWriter::writePadding(ofstream& out, size_t bytes) {
+	static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	out.write(zeros, BinaryFormat::align(bytes) - bytes);
+}
+
+void BinaryOutputWriter::writeSection(ofstream& out, const void* section, size_t bytes) {
+	if (bytes > 0) {
+		out.write(static_cast<const char*>(section), bytes);
+	}
+	writePadding(out, bytes);
+}
+
+void BinaryOutputWriter::writeFile(const char* fileName) {
+
+	const int nCols = data.getNumberOfColumns();
+
+	// Column table, with entries laid out in CSC order
+	vector<BinaryFormat::Column> table(nCols);
+	string columnLabels;
+	int64_t indexLength = 0;
+	int64_t dataLength = 0;
+	for (int j = 0; j < nCols; ++j) {
+		CompressedDataColumn& column = data.getColumn(j);
+		BinaryFormat::Column& entry = table[j];
+		entry.formatType = column.getFormatType();
+		entry.numericalName = column.getNumericalLabel();
+		entry.indexOffset = indexLength;
+		entry.nIndices = column.hasColumns() ? column.getNumberOfWords() : 0;
+		entry.dataOffset = dataLength;
+		entry.nValues = column.hasData() ? column.getDataVectorLength() : 0;
+		entry.labelLength = column.getLabel().size();
+		columnLabels += column.getLabel();
+		indexLength += entry.nIndices;
+		dataLength += entry.nValues;
+	}
+
+	vector<int64_t> labelLengths;
+	string labels;
+	for (size_t i = 0; i < data.labels.size(); ++i) {
+		labelLengths.push_back(data.labels[i].size());
+		labels += data.labels[i];
+	}
+
+	BinaryFormat::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BinaryFormat::magic, sizeof(header.magic));
+	header.version = BinaryFormat::version;
+	header.byteOrder = BinaryFormat::byteOrder;
+	header.realSize = sizeof(real);
+	header.hasOffsetCovariate = data.hasOffsetCovariate;
+	header.hasInterceptCovariate = data.hasInterceptCovariate;
+	header.nRows = data.nRows;
+	header.nCols = nCols;
+	header.nPatients = data.nPatients;
+	header.nEntries = data.nEntries;
+	header.conditionIdLength = data.conditionId.size();
+	header.pidLength = data.pid.size();
+	header.yLength = data.y.size();
+	header.zLength = data.z.size();
+	header.offsLength = data.offs.size();
+	header.neventsLength = data.nevents.size();
+	header.nLabels = labelLengths.size();
+	header.labelBytes = labels.size();
+	header.columnLabelBytes = columnLabels.size();
+	header.indexLength = indexLength;
+	header.dataLength = dataLength;
+
+	ofstream out;
+	out.open(fileName, ios::out | ios::binary);
+	if (!out) {
+		cerr << "Unable to open binary file " << fileName << endl;
+		exit(-1);
+	}
+
+	writeSection(out, &header, sizeof(header));
+	writeSection(out, data.conditionId.data(), data.conditionId.size());
+	writeSection(out, data.pid.data(), data.pid.size() * sizeof(int));
+	writeSection(out, data.y.data(), data.y.size() * sizeof(real));
+	writeSection(out, data.z.data(), data.z.size() * sizeof(real));
+	writeSection(out, data.offs.data(), data.offs.size() * sizeof(real));
+	writeSection(out, data.nevents.data(), data.nevents.size() * sizeof(int));
+	writeSection(out, labelLengths.data(), labelLengths.size() * sizeof(int64_t));
+	writeSection(out, labels.data(), labels.size());
+	writeSection(out, table.data(), table.size() * sizeof(BinaryFormat::Column));
+	writeSection(out, columnLabels.data(), columnLabels.size());
+
+	// Arenas are streamed one column at a time
+	const size_t indexBytes = indexLength * sizeof(int);
+	for (int j = 0; j < nCols; ++j) {
+		if (table[j].nIndices > 0) {
+			out.write(reinterpret_cast<const char*>(data.getColumn(j).getColumns()),
+					table[j].nIndices * sizeof(int));
+		}
+	}
+	writePadding(out, indexBytes);
+
+	const size_t dataBytes = dataLength * sizeof(real);
+	for (int j = 0; j < nCols; ++j) {
+		if (table[j].nValues > 0) {
+			out.write(reinterpret_cast<const char*>(data.getColumn(j).getData()),
+					table[j].nValues * sizeof(real));
+		}
+	}
+	writePadding(out, dataBytes);
+
+	if (!out) {
+		cerr << "Error writing binary file " << fileName << endl;
+		exit(-1);
+	}
+	out.close();
+}
+
+} // namespace
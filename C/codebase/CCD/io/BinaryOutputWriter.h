@@ -0,0 +1,44 @@
+/*
+ * BinaryOutputWriter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef BINARYOUTPUTWRITER_H_
+#define BINARYOUTPUTWRITER_H_
+
+#include <fstream>
+
+#include "OutputWriter.h"
+#include "BinaryFormat.h"
+
+namespace bsccs {
+
+/*
+ * Saves a loaded ModelData in the layout described in BinaryFormat.h, for later runs to
+ * open with BinaryInputReader instead of re-parsing the text file.
+ */
+class BinaryOutputWriter : public OutputWriter {
+public:
+	BinaryOutputWriter(ModelData& _data) : OutputWriter(), data(_data) {
+		// Do nothing
+	}
+
+	virtual ~BinaryOutputWriter() {
+		// Do nothing
+	}
+
+	virtual void writeFile(const char* fileName);
+
+private:
+	void writePadding(std::ofstream& out, size_t bytes);
+
+	void writeSection(std::ofstream& out, const void* section, size_t bytes);
+
+	ModelData& data;
+};
+
+} // namespace
+
+#endif /* BINARYOUTPUTWRITER_H_ */
@@ -133,6 +133,7 @@ void CCTestInputReader::readFile(const char* fileName) {
 	modelData->nPatients = numCases;
 	modelData->nRows = currentRow;
 	modelData->conditionId = "0";
+	modelData->finalize();
 }
 
 } // namespace
@@ -217,6 +217,7 @@ void CLRInputReader::readFile(const char* fileName) {
 	modelData->nPatients = numCases;
 	modelData->nRows = currentEntry;
 	modelData->conditionId = outcomeId;
+	modelData->finalize();
 
 }
 
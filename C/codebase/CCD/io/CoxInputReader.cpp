@@ -112,6 +112,7 @@ void CoxInputReader::readFile(const char* fileName) {
 	modelData->nPatients = numCases;
 	modelData->nRows = currentRow;
 	modelData->conditionId = "0";
+	modelData->finalize();
 	
 	cerr << "Total 0: " << modelData->getColumn(0).sumColumn(currentRow) << endl;
 	cerr << "Total 1: " << modelData->getColumn(1).sumColumn(currentRow) << endl;
@@ -40,7 +40,12 @@ namespace bsccs {
 
 using namespace std;
 
-InputReader::InputReader() : modelData(new ModelData()), deleteModelData(true) {
+InputReader::InputReader() : modelData(new ModelData()), deleteModelData(true), nThreads(1) {
+	// Do nothing
+}
+
+InputReader::InputReader(const InputReader& reader) : modelData(new ModelData()),
+		deleteModelData(true), nThreads(1) {
 	// Do nothing
 }
 
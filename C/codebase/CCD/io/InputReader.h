@@ -40,8 +40,16 @@ public:
 	InputReader();
 	virtual ~InputReader();
 
+	// Copies share the configuration of a reader but parse into their own ModelData
+	InputReader(const InputReader& reader);
+
 	virtual void readFile(const char* fileName) = 0;
 
+	// Readers that support it parse with up to this many threads
+	void setThreads(int threads) {
+		nThreads = threads;
+	}
+
 	ModelData* getModelData() {
 		// TODO Use smart pointer
 		deleteModelData = false;
@@ -97,6 +105,10 @@ protected:
 
 	ModelData* modelData;
 	bool deleteModelData;
+	int nThreads;
+
+private:
+	InputReader& operator = (const InputReader&);
 };
 
 } // namespace
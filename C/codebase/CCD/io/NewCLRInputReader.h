@@ -14,7 +14,7 @@ namespace bsccs {
 
 class NewCLRInputReader : public BaseInputReader<NewCLRInputReader> {
 public:
-	inline void parseRow(stringstream& ss, RowInformation& rowInfo) {
+	inline void parseRow(RowTokenizer& ss, RowInformation& rowInfo) {
 		parseSingleBBROutcomeEntry<int>(ss, rowInfo);
 		parseStratumEntry(ss, rowInfo);
 		parseAllBBRCovariatesEntry(ss, rowInfo,false);
@@ -23,6 +23,10 @@ public:
 	void parseHeader(ifstream& in) {
 		// Do nothing
 	}
+
+	int getStratumColumn() const {
+		return 1;
+	}
 	
 };
 
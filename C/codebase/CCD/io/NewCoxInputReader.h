@@ -16,7 +16,7 @@ namespace bsccs {
 
 class NewCoxInputReader : public BaseInputReader<NewCoxInputReader> {
 public:
-	inline void parseRow(stringstream& ss, RowInformation& rowInfo) {		
+	inline void parseRow(RowTokenizer& ss, RowInformation& rowInfo) {		
 		parseNoStratumEntry(ss, rowInfo);
 		parseSingleTimeEntry<float>(ss, rowInfo);
 		parseSingleOutcomeEntry<int>(ss, rowInfo);	
@@ -72,7 +72,7 @@ public:
 //		std::cerr << includeStratumLabel << std::endl << std::endl;
 	}
 
-	inline void parseRow(stringstream& ss, RowInformation& rowInfo) {
+	inline void parseRow(RowTokenizer& ss, RowInformation& rowInfo) {
 
 //		std::cerr << includeRowLabel << std::endl;
 //		std::cerr << includeStratumLabel << std::endl;
@@ -118,6 +118,13 @@ public:
 		parseAllBBRCovariatesEntry(ss, rowInfo, indicatorOnly);
 	}
 
+	int getStratumColumn() const {
+		if (!includeStratumLabel) {
+			return -1;
+		}
+		return includeRowLabel ? 1 : 0;
+	}
+
 	void parseHeader(ifstream& in) {
 		int firstChar = in.peek();
 		if (firstChar == '#') { // There is a header
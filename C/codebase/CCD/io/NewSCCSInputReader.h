@@ -14,7 +14,7 @@ namespace bsccs {
 
 class NewSCCSInputReader : public BaseInputReader<NewSCCSInputReader> {
 public:
-	inline void parseRow(stringstream& ss, RowInformation& rowInfo) {
+	inline void parseRow(RowTokenizer& ss, RowInformation& rowInfo) {
 		parseConditionEntry(ss, rowInfo);
 		parseStratumEntry(ss, rowInfo);
 		parseSingleOutcomeEntry<int>(ss, rowInfo);
@@ -22,6 +22,10 @@ public:
 		parseAllIndicatorCovariatesEntry(ss, rowInfo);
 	}
 
+	int getStratumColumn() const {
+		return 1;
+	}
+
 protected:
 
 };
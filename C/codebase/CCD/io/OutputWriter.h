@@ -63,7 +63,7 @@ public:
 
 	virtual void writeFile(const char* fileName) {
 		ofstream out;
-		out.open(fileName, ios::out);
+		out.open(fileName, std::ios::out);
 		writeFile(out);
 	}
 
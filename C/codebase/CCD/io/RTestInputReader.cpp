@@ -122,6 +122,7 @@ void RTestInputReader::readFile(const char* fileName) {
 	modelData->nPatients = numCases;
 	modelData->nRows = currentRow;
 	modelData->conditionId = "0";
+	modelData->finalize();
 
 }
 
@@ -0,0 +1,102 @@
+#ifndef ROWTOKENIZER_H_
+#define ROWTOKENIZER_H_
+
+#include <cstdlib>
+#include <string>
+
+namespace bsccs {
+
+/*
+ * Whitespace tokenizer over one row of an in-memory file, used in place of a stringstream.
+ * Numbers are converted straight from the buffer without allocation; the buffer must be
+ * terminated past the last row so conversions always stop.
+ */
+class RowTokenizer {
+public:
+	RowTokenizer(const char* _begin, const char* _end) : position(_begin), end(_end), valid(true) {
+		// Do nothing
+	}
+
+	// Returns false and an empty token once the row is exhausted
+	bool nextToken(const char*& tokenBegin, const char*& tokenEnd) {
+		while (position < end && isSpace(*position)) {
+			++position;
+		}
+		tokenBegin = position;
+		while (position < end && !isSpace(*position)) {
+			++position;
+		}
+		tokenEnd = position;
+		if (tokenBegin == tokenEnd) {
+			valid = false;
+		}
+		return valid;
+	}
+
+	RowTokenizer& operator>>(std::string& value) {
+		const char* tokenBegin;
+		const char* tokenEnd;
+		if (nextToken(tokenBegin, tokenEnd)) {
+			value.assign(tokenBegin, tokenEnd - tokenBegin);
+		}
+		return *this;
+	}
+
+	RowTokenizer& operator>>(int& value) {
+		const char* tokenBegin;
+		const char* tokenEnd;
+		if (nextToken(tokenBegin, tokenEnd)) {
+			value = parseInt(tokenBegin, tokenEnd);
+		}
+		return *this;
+	}
+
+	RowTokenizer& operator>>(float& value) {
+		const char* tokenBegin;
+		const char* tokenEnd;
+		if (nextToken(tokenBegin, tokenEnd)) {
+			value = strtof(tokenBegin, NULL);
+		}
+		return *this;
+	}
+
+	RowTokenizer& operator>>(double& value) {
+		const char* tokenBegin;
+		const char* tokenEnd;
+		if (nextToken(tokenBegin, tokenEnd)) {
+			value = strtod(tokenBegin, NULL);
+		}
+		return *this;
+	}
+
+	explicit operator bool() const {
+		return valid;
+	}
+
+	// Same result as atoi() on the token
+	static int parseInt(const char* begin, const char* end) {
+		bool negative = false;
+		if (begin < end && (*begin == '-' || *begin == '+')) {
+			negative = (*begin == '-');
+			++begin;
+		}
+		int value = 0;
+		for (; begin < end && *begin >= '0' && *begin <= '9'; ++begin) {
+			value = 10 * value + (*begin - '0');
+		}
+		return negative ? -value : value;
+	}
+
+private:
+	static bool isSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+	}
+
+	const char* position;
+	const char* end;
+	bool valid;
+};
+
+} // namespace
+
+#endif /* ROWTOKENIZER_H_ */
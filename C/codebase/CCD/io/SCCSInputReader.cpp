@@ -167,6 +167,7 @@ void SCCSInputReader::readFile(const char* fileName) {
 	modelData->nPatients = numPatients;
 	modelData->nRows = currentEntry;
 	modelData->conditionId = outcomeId;
+	modelData->finalize();
 
 #if 0
 	cout << "Converting first column to dense format" << endl;
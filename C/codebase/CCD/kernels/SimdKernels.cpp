@@ -0,0 +1,32 @@
+/*
+ * SimdKernels.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include <cstddef>
+
+#include "SimdKernels.h"
+
+namespace bsccs {
+
+template <typename RealType>
+const SimdKernels<RealType>* SimdKernels<RealType>::get() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && getAvx512Kernels<RealType>() != NULL) {
+		return getAvx512Kernels<RealType>();
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+			&& getAvx2Kernels<RealType>() != NULL) {
+		return getAvx2Kernels<RealType>();
+	}
+#endif
+	return NULL;
+}
+
+template struct SimdKernels<float>;
+template struct SimdKernels<double>;
+
+} // namespace
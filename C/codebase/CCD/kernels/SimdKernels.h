@@ -0,0 +1,62 @@
+/*
+ * SimdKernels.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef SIMDKERNELS_H_
+#define SIMDKERNELS_H_
+
+namespace bsccs {
+
+/*
+ * Vectorized loops over all K rows for DENSE and INTERCEPT columns of the independent-data
+ * models (LR, Poisson, least squares).  Each table is compiled for one instruction set in
+ * its own translation unit and chosen once at run-time from the CPU features; get() returns
+ * NULL when none is usable, in which case ModelSpecifics keeps its templated scalar loops.
+ *
+ * A NULL column x means an intercept (x == 1); NULL weights mean all rows are included.
+ */
+template <typename RealType>
+struct SimdKernels {
+	const char* name;
+
+	// xBeta += delta * x, offsExpXBeta = exp(xBeta) and denom += change in offsExpXBeta
+	void (*updateXBetaExp)(int n, RealType delta, const RealType* x,
+			RealType* xBeta, RealType* offsExpXBeta, RealType* denom);
+
+	// xBeta += delta * x; given y, returns the change in -sum w * (y - xBeta)^2 (else 0)
+	double (*updateXBeta)(int n, RealType delta, const RealType* x, RealType* xBeta,
+			const RealType* y, const RealType* weights);
+
+	/*
+	 * Single-pass gradient and Hessian, forming the numerators numer = offsExpXBeta * x and
+	 * numer2 = offsExpXBeta * x^2 (or 2 * x * (xBeta - y) for least squares) in registers
+	 */
+
+	// gradient = sum w * numer / denom, hessian = sum w * (numer2 / denom - (numer / denom)^2)
+	void (*logisticGradientAndHessian)(int n, const RealType* x, const RealType* offsExpXBeta,
+			const RealType* denom, const RealType* weights, RealType* gradient, RealType* hessian);
+
+	// gradient = sum w * numer, hessian = sum w * numer2
+	void (*poissonGradientAndHessian)(int n, const RealType* x, const RealType* offsExpXBeta,
+			const RealType* unused, const RealType* weights, RealType* gradient, RealType* hessian);
+
+	// gradient = sum w * 2 * x * (xBeta - y), hessian = 0
+	void (*leastSquaresGradientAndHessian)(int n, const RealType* x, const RealType* xBeta,
+			const RealType* y, const RealType* weights, RealType* gradient, RealType* hessian);
+
+	static const SimdKernels* get();
+};
+
+// Defined in the per-instruction-set translation units; NULL when not compiled in
+template <typename RealType>
+const SimdKernels<RealType>* getAvx2Kernels();
+
+template <typename RealType>
+const SimdKernels<RealType>* getAvx512Kernels();
+
+} // namespace
+
+#endif /* SIMDKERNELS_H_ */
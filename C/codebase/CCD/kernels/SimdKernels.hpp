@@ -0,0 +1,397 @@
+/*
+ * SimdKernels.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#ifndef SIMDKERNELS_HPP_
+#define SIMDKERNELS_HPP_
+
+#include <cmath>
+
+#include "SimdKernels.h"
+
+namespace bsccs {
+
+/*
+ * Kernels written once against a vector traits class V, which each instruction-set
+ * translation unit supplies (in an anonymous namespace, so that no code compiled for one
+ * instruction set is shared with the rest of the program).  V provides:
+ *
+ * 	Real, Vec, Cmp, Mask, width
+ * 	load, store, set1, zero, add, sub, mul, div, min, max, round
+ * 	fmadd(a, b, c) = a * b + c, fnmadd(a, b, c) = c - a * b
+ * 	greater, less, blend(cmp, ifTrue, ifFalse), scale2(y, n) = y * 2^n for integral n
+ * 	tailMask(count), maskLoad(p, mask, fill), maskStore(p, mask, v)
+ *
+ * Only intrinsics and operators are used here; calls into std:: would be emitted as
+ * shared inline functions compiled with the wider instruction set.
+ */
+
+// Whole vectors of rows
+template <class V>
+struct FullAccess {
+	typedef typename V::Real Real;
+	typedef typename V::Vec Vec;
+
+	Vec load(const Real* p) const {
+		return V::load(p);
+	}
+
+	Vec load(const Real* p, Vec fill) const {
+		return V::load(p);
+	}
+
+	void store(Real* p, Vec v) const {
+		V::store(p, v);
+	}
+};
+
+// Final partial vector; lanes past the end read as fill and are never written
+template <class V>
+struct TailAccess {
+	typedef typename V::Real Real;
+	typedef typename V::Vec Vec;
+
+	TailAccess(int count) : mask(V::tailMask(count)) {
+		// Do nothing
+	}
+
+	Vec load(const Real* p) const {
+		return V::maskLoad(p, mask, V::zero());
+	}
+
+	Vec load(const Real* p, Vec fill) const {
+		return V::maskLoad(p, mask, fill);
+	}
+
+	void store(Real* p, Vec v) const {
+		V::maskStore(p, mask, v);
+	}
+
+	typename V::Mask mask;
+};
+
+template <class V, class Step>
+inline void forEachVector(int n, Step& step) {
+	int k = 0;
+	for (; k + V::width <= n; k += V::width) {
+		step(FullAccess<V>(), k);
+	}
+	if (k < n) {
+		step(TailAccess<V>(n - k), k);
+	}
+}
+
+template <class V>
+inline double horizontalSum(typename V::Vec v) {
+	typename V::Real lanes[V::width];
+	V::store(lanes, v);
+	double total = 0.0;
+	for (int i = 0; i < V::width; ++i) {
+		total += lanes[i];
+	}
+	return total;
+}
+
+/*
+ * exp() after Cephes: reduce by n = round(x / log(2)) in two parts, evaluate a polynomial
+ * (float) or Pade approximant (double) on [-log(2)/2, log(2)/2] and scale by 2^n.  Results
+ * agree with std::exp to a few ulp over the normal range; arguments past the range give
+ * inf or 0 and NaN propagates through the clamp.
+ */
+template <class V, typename Real>
+struct VectorExp;
+
+template <class V>
+struct VectorExp<V, float> {
+	typedef typename V::Vec Vec;
+
+	static Vec eval(Vec x) {
+		const Vec lower = V::set1(-87.3365447504019f); // Smallest normal result
+		const Vec upper = V::set1(88.3762626647949f); // Largest result with n = 127
+		const Vec xc = V::min(upper, V::max(lower, x));
+		const Vec n = V::round(V::mul(xc, V::set1(1.44269504088896341f)));
+		Vec r = V::fnmadd(n, V::set1(0.693359375f), xc);
+		r = V::fnmadd(n, V::set1(-2.12194440e-4f), r);
+
+		Vec p = V::set1(1.9875691500E-4f);
+		p = V::fmadd(p, r, V::set1(1.3981999507E-3f));
+		p = V::fmadd(p, r, V::set1(8.3334519073E-3f));
+		p = V::fmadd(p, r, V::set1(4.1665795894E-2f));
+		p = V::fmadd(p, r, V::set1(1.6666665459E-1f));
+		p = V::fmadd(p, r, V::set1(5.0000001201E-1f));
+		p = V::fmadd(p, V::mul(r, r), V::add(r, V::set1(1.0f)));
+
+		Vec result = V::scale2(p, n);
+		result = V::blend(V::greater(x, V::set1(88.72283905206835f)),
+				V::set1(static_cast<float>(HUGE_VAL)), result);
+		return V::blend(V::less(x, lower), V::zero(), result);
+	}
+};
+
+template <class V>
+struct VectorExp<V, double> {
+	typedef typename V::Vec Vec;
+
+	static Vec eval(Vec x) {
+		const Vec lower = V::set1(-708.3964185322641); // Smallest normal result
+		const Vec upper = V::set1(709.0); // Largest result with n = 1023
+		const Vec xc = V::min(upper, V::max(lower, x));
+		const Vec n = V::round(V::mul(xc, V::set1(1.4426950408889634073599)));
+		Vec r = V::fnmadd(n, V::set1(6.93145751953125E-1), xc);
+		r = V::fnmadd(n, V::set1(1.42860682030941723212E-6), r);
+
+		const Vec rr = V::mul(r, r);
+		Vec p = V::set1(1.26177193074810590878E-4);
+		p = V::fmadd(p, rr, V::set1(3.02994407707441961300E-2));
+		p = V::fmadd(p, rr, V::set1(9.99999999999999999910E-1));
+		p = V::mul(p, r);
+		Vec q = V::set1(3.00198505138664455042E-6);
+		q = V::fmadd(q, rr, V::set1(2.52448340349684104192E-3));
+		q = V::fmadd(q, rr, V::set1(2.27265548208155028766E-1));
+		q = V::fmadd(q, rr, V::set1(2.0));
+		const Vec e = V::fmadd(V::set1(2.0), V::div(p, V::sub(q, p)), V::set1(1.0));
+
+		Vec result = V::scale2(e, n);
+		result = V::blend(V::greater(x, V::set1(709.782712893384)), V::set1(HUGE_VAL), result);
+		return V::blend(V::less(x, lower), V::zero(), result);
+	}
+};
+
+template <class V, bool HasX>
+struct UpdateXBetaExpStep {
+	typedef typename V::Real Real;
+	typedef typename V::Vec Vec;
+
+	Vec delta;
+	const Real* x;
+	Real* xBeta;
+	Real* offsExpXBeta;
+	Real* denom;
+
+	template <class Access>
+	void operator()(const Access& a, int k) {
+		Vec xb = a.load(xBeta + k);
+		xb = HasX ? V::fmadd(delta, a.load(x + k), xb) : V::add(xb, delta);
+		a.store(xBeta + k, xb);
+		const Vec newEntry = VectorExp<V, Real>::eval(xb);
+		a.store(denom + k, V::add(a.load(denom + k), V::sub(newEntry, a.load(offsExpXBeta + k))));
+		a.store(offsExpXBeta + k, newEntry);
+	}
+};
+
+// Tracked steps also sum the change in -w * (y - xBeta)^2
+template <class V, bool HasX, bool Tracked, bool Weighted>
+struct UpdateXBetaStep {
+	typedef typename V::Real Real;
+	typedef typename V::Vec Vec;
+
+	Vec delta;
+	const Real* x;
+	Real* xBeta;
+	const Real* y;
+	const Real* weights;
+	Vec change;
+
+	template <class Access>
+	void operator()(const Access& a, int k) {
+		const Vec xb = a.load(xBeta + k);
+		a.store(xBeta + k, HasX ? V::fmadd(delta, a.load(x + k), xb) : V::add(xb, delta));
+		if (Tracked) {
+			// Reloaded, so lanes past the end read zeros before and after
+			const Vec yk = a.load(y + k);
+			const Vec oldResidual = V::sub(yk, xb);
+			const Vec newResidual = V::sub(yk, a.load(xBeta + k));
+			const Vec c = V::fnmadd(newResidual, newResidual, V::mul(oldResidual, oldResidual));
+			change = Weighted ? V::fmadd(a.load(weights + k), c, change) : V::add(change, c);
+		}
+	}
+};
+
+/*
+ * Gradient and Hessian reductions over (x, first, second, weights); lanes past the end read
+ * zeros (and a unit denominator), so contribute nothing
+ */
+template <class V, bool HasX, bool Weighted>
+struct ReductionStep {
+	typedef typename V::Real Real;
+	typedef typename V::Vec Vec;
+
+	const Real* x;
+	const Real* first;
+	const Real* second;
+	const Real* weights;
+	Vec gradient;
+	Vec hessian;
+
+	template <class Access>
+	void accumulate(const Access& a, int k, Vec g, Vec h) {
+		if (Weighted) {
+			const Vec w = a.load(weights + k);
+			gradient = V::fmadd(w, g, gradient);
+			hessian = V::fmadd(w, h, hessian);
+		} else {
+			gradient = V::add(gradient, g);
+			hessian = V::add(hessian, h);
+		}
+	}
+};
+
+// first = offsExpXBeta, second = denom
+template <class V, bool HasX, bool Weighted>
+struct LogisticStep : public ReductionStep<V, HasX, Weighted> {
+	typedef typename V::Real Real;
+	typedef typename V::Vec Vec;
+
+	template <class Access>
+	void operator()(const Access& a, int k) {
+		const Vec predictor = a.load(this->first + k);
+		const Vec d = a.load(this->second + k, V::set1(static_cast<Real>(1)));
+		Vec numer = predictor;
+		Vec numer2 = predictor;
+		if (HasX) {
+			const Vec xk = a.load(this->x + k);
+			numer = V::mul(predictor, xk);
+			numer2 = V::mul(numer, xk);
+		}
+		const Vec g = V::div(numer, d);
+		this->accumulate(a, k, g, V::fnmadd(g, g, V::div(numer2, d))); // Bounded by x_j^2
+	}
+};
+
+// first = offsExpXBeta
+template <class V, bool HasX, bool Weighted>
+struct PoissonStep : public ReductionStep<V, HasX, Weighted> {
+	typedef typename V::Vec Vec;
+
+	template <class Access>
+	void operator()(const Access& a, int k) {
+		const Vec predictor = a.load(this->first + k);
+		if (HasX) {
+			const Vec xk = a.load(this->x + k);
+			const Vec numer = V::mul(predictor, xk);
+			this->accumulate(a, k, numer, V::mul(numer, xk));
+		} else {
+			this->accumulate(a, k, predictor, predictor);
+		}
+	}
+};
+
+// first = xBeta, second = y
+template <class V, bool HasX, bool Weighted>
+struct LeastSquaresStep : public ReductionStep<V, HasX, Weighted> {
+	typedef typename V::Vec Vec;
+
+	template <class Access>
+	void operator()(const Access& a, int k) {
+		Vec numer = V::sub(a.load(this->first + k), a.load(this->second + k));
+		numer = V::add(numer, numer);
+		if (HasX) {
+			numer = V::mul(a.load(this->x + k), numer);
+		}
+		this->accumulate(a, k, numer, V::zero());
+	}
+};
+
+// Entry points for the SimdKernels table; run-time NULL checks pick the compile-time variant
+template <class V>
+struct KernelTable {
+	typedef typename V::Real Real;
+
+	static void updateXBetaExp(int n, Real delta, const Real* x,
+			Real* xBeta, Real* offsExpXBeta, Real* denom) {
+		if (x) {
+			UpdateXBetaExpStep<V, true> step = { V::set1(delta), x, xBeta, offsExpXBeta, denom };
+			forEachVector<V>(n, step);
+		} else {
+			UpdateXBetaExpStep<V, false> step = { V::set1(delta), x, xBeta, offsExpXBeta, denom };
+			forEachVector<V>(n, step);
+		}
+	}
+
+	static double updateXBeta(int n, Real delta, const Real* x, Real* xBeta,
+			const Real* y, const Real* weights) {
+		if (!y) {
+			return x ? update<true, false, false>(n, delta, x, xBeta, y, weights)
+					: update<false, false, false>(n, delta, x, xBeta, y, weights);
+		} else if (weights) {
+			return x ? update<true, true, true>(n, delta, x, xBeta, y, weights)
+					: update<false, true, true>(n, delta, x, xBeta, y, weights);
+		} else {
+			return x ? update<true, true, false>(n, delta, x, xBeta, y, weights)
+					: update<false, true, false>(n, delta, x, xBeta, y, weights);
+		}
+	}
+
+	static void logisticGradientAndHessian(int n, const Real* x, const Real* offsExpXBeta,
+			const Real* denom, const Real* weights, Real* gradient, Real* hessian) {
+		reduce<LogisticStep>(n, x, offsExpXBeta, denom, weights, gradient, hessian);
+	}
+
+	static void poissonGradientAndHessian(int n, const Real* x, const Real* offsExpXBeta,
+			const Real* unused, const Real* weights, Real* gradient, Real* hessian) {
+		reduce<PoissonStep>(n, x, offsExpXBeta, unused, weights, gradient, hessian);
+	}
+
+	static void leastSquaresGradientAndHessian(int n, const Real* x, const Real* xBeta,
+			const Real* y, const Real* weights, Real* gradient, Real* hessian) {
+		reduce<LeastSquaresStep>(n, x, xBeta, y, weights, gradient, hessian);
+	}
+
+	static SimdKernels<Real> make(const char* name) {
+		SimdKernels<Real> table = {
+				name,
+				&updateXBetaExp,
+				&updateXBeta,
+				&logisticGradientAndHessian,
+				&poissonGradientAndHessian,
+				&leastSquaresGradientAndHessian
+		};
+		return table;
+	}
+
+private:
+	template <bool HasX, bool Tracked, bool Weighted>
+	static double update(int n, Real delta, const Real* x, Real* xBeta,
+			const Real* y, const Real* weights) {
+		UpdateXBetaStep<V, HasX, Tracked, Weighted> step =
+				{ V::set1(delta), x, xBeta, y, weights, V::zero() };
+		forEachVector<V>(n, step);
+		return Tracked ? horizontalSum<V>(step.change) : 0.0;
+	}
+
+	template <template <class, bool, bool> class Step, bool HasX, bool Weighted>
+	static void reduce(int n, const Real* x, const Real* first, const Real* second,
+			const Real* weights, Real* gradient, Real* hessian) {
+		Step<V, HasX, Weighted> step;
+		step.x = x;
+		step.first = first;
+		step.second = second;
+		step.weights = weights;
+		step.gradient = V::zero();
+		step.hessian = V::zero();
+		forEachVector<V>(n, step);
+		*gradient = static_cast<Real>(horizontalSum<V>(step.gradient));
+		*hessian = static_cast<Real>(horizontalSum<V>(step.hessian));
+	}
+
+	template <template <class, bool, bool> class Step>
+	static void reduce(int n, const Real* x, const Real* first, const Real* second,
+			const Real* weights, Real* gradient, Real* hessian) {
+		if (x && weights) {
+			reduce<Step, true, true>(n, x, first, second, weights, gradient, hessian);
+		} else if (x) {
+			reduce<Step, true, false>(n, x, first, second, weights, gradient, hessian);
+		} else if (weights) {
+			reduce<Step, false, true>(n, x, first, second, weights, gradient, hessian);
+		} else {
+			reduce<Step, false, false>(n, x, first, second, weights, gradient, hessian);
+		}
+	}
+};
+
+} // namespace
+
+#endif /* SIMDKERNELS_HPP_ */
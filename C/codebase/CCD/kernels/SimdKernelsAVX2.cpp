@@ -0,0 +1,147 @@
+/*
+ * SimdKernelsAVX2.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include <cstddef>
+
+#include "SimdKernels.h"
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+#include <immintrin.h>
+
+#include "SimdKernels.hpp"
+
+namespace bsccs {
+
+namespace {
+
+struct Avx2Float {
+	typedef float Real;
+	typedef __m256 Vec;
+	typedef __m256 Cmp;
+	typedef __m256i Mask;
+	enum { width = 8 };
+
+	static Vec load(const Real* p) { return _mm256_loadu_ps(p); }
+	static void store(Real* p, Vec v) { _mm256_storeu_ps(p, v); }
+	static Vec set1(Real a) { return _mm256_set1_ps(a); }
+	static Vec zero() { return _mm256_setzero_ps(); }
+	static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+	static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+	static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+	static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+	static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+	static Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+	static Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+	static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm256_fnmadd_ps(a, b, c); }
+	static Vec round(Vec a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static Cmp greater(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Cmp less(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Vec blend(Cmp c, Vec ifTrue, Vec ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, c); }
+
+	static Vec scale2(Vec y, Vec n) {
+		const __m256i exponent = _mm256_slli_epi32(
+				_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+	}
+
+	static Mask tailMask(int count) {
+		return _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	}
+
+	static Vec maskLoad(const Real* p, Mask m, Vec fill) {
+		return _mm256_blendv_ps(fill, _mm256_maskload_ps(p, m), _mm256_castsi256_ps(m));
+	}
+
+	static void maskStore(Real* p, Mask m, Vec v) { _mm256_maskstore_ps(p, m, v); }
+};
+
+struct Avx2Double {
+	typedef double Real;
+	typedef __m256d Vec;
+	typedef __m256d Cmp;
+	typedef __m256i Mask;
+	enum { width = 4 };
+
+	static Vec load(const Real* p) { return _mm256_loadu_pd(p); }
+	static void store(Real* p, Vec v) { _mm256_storeu_pd(p, v); }
+	static Vec set1(Real a) { return _mm256_set1_pd(a); }
+	static Vec zero() { return _mm256_setzero_pd(); }
+	static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+	static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+	static Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+	static Vec div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+	static Vec min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+	static Vec max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+	static Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_pd(a, b, c); }
+	static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm256_fnmadd_pd(a, b, c); }
+	static Vec round(Vec a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static Cmp greater(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	static Cmp less(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static Vec blend(Cmp c, Vec ifTrue, Vec ifFalse) { return _mm256_blendv_pd(ifFalse, ifTrue, c); }
+
+	static Vec scale2(Vec y, Vec n) {
+		// Adding 2^52 leaves n + 1023 in the low mantissa bits; shift it into the exponent
+		const __m256d shifted = _mm256_add_pd(n, _mm256_set1_pd(4503599627370496.0 + 1023.0));
+		const __m256i exponent = _mm256_slli_epi64(_mm256_castpd_si256(shifted), 52);
+		return _mm256_mul_pd(y, _mm256_castsi256_pd(exponent));
+	}
+
+	static Mask tailMask(int count) {
+		return _mm256_cmpgt_epi64(_mm256_set1_epi64x(count), _mm256_setr_epi64x(0, 1, 2, 3));
+	}
+
+	static Vec maskLoad(const Real* p, Mask m, Vec fill) {
+		return _mm256_blendv_pd(fill, _mm256_maskload_pd(p, m), _mm256_castsi256_pd(m));
+	}
+
+	static void maskStore(Real* p, Mask m, Vec v) { _mm256_maskstore_pd(p, m, v); }
+};
+
+template <typename RealType>
+struct Avx2Vector;
+
+template <>
+struct Avx2Vector<float> {
+	typedef Avx2Float type;
+};
+
+template <>
+struct Avx2Vector<double> {
+	typedef Avx2Double type;
+};
+
+} // namespace
+
+template <typename RealType>
+const SimdKernels<RealType>* getAvx2Kernels() {
+	static const SimdKernels<RealType> kernels =
+			KernelTable<typename Avx2Vector<RealType>::type>::make("avx2");
+	return &kernels;
+}
+
+} // namespace
+
+#else
+
+namespace bsccs {
+
+template <typename RealType>
+const SimdKernels<RealType>* getAvx2Kernels() {
+	return NULL; // Not compiled for AVX2
+}
+
+} // namespace
+
+#endif
+
+namespace bsccs {
+
+template const SimdKernels<float>* getAvx2Kernels<float>();
+template const SimdKernels<double>* getAvx2Kernels<double>();
+
+} // namespace
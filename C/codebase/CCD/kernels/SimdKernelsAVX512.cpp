@@ -0,0 +1,122 @@
+/*
+ * SimdKernelsAVX512.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: msuchard
+ */
+
+#include <cstddef>
+
+#include "SimdKernels.h"
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+#include "SimdKernels.hpp"
+
+namespace bsccs {
+
+namespace {
+
+struct Avx512Float {
+	typedef float Real;
+	typedef __m512 Vec;
+	typedef __mmask16 Cmp;
+	typedef __mmask16 Mask;
+	enum { width = 16 };
+
+	static Vec load(const Real* p) { return _mm512_loadu_ps(p); }
+	static void store(Real* p, Vec v) { _mm512_storeu_ps(p, v); }
+	static Vec set1(Real a) { return _mm512_set1_ps(a); }
+	static Vec zero() { return _mm512_setzero_ps(); }
+	static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+	static Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+	static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+	static Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+	static Vec min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+	static Vec max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+	static Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+	static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm512_fnmadd_ps(a, b, c); }
+	static Vec round(Vec a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static Cmp greater(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+	static Cmp less(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static Vec blend(Cmp c, Vec ifTrue, Vec ifFalse) { return _mm512_mask_blend_ps(c, ifFalse, ifTrue); }
+	static Vec scale2(Vec y, Vec n) { return _mm512_scalef_ps(y, n); }
+	static Mask tailMask(int count) { return static_cast<Mask>((1u << count) - 1u); }
+	static Vec maskLoad(const Real* p, Mask m, Vec fill) { return _mm512_mask_loadu_ps(fill, m, p); }
+	static void maskStore(Real* p, Mask m, Vec v) { _mm512_mask_storeu_ps(p, m, v); }
+};
+
+struct Avx512Double {
+	typedef double Real;
+	typedef __m512d Vec;
+	typedef __mmask8 Cmp;
+	typedef __mmask8 Mask;
+	enum { width = 8 };
+
+	static Vec load(const Real* p) { return _mm512_loadu_pd(p); }
+	static void store(Real* p, Vec v) { _mm512_storeu_pd(p, v); }
+	static Vec set1(Real a) { return _mm512_set1_pd(a); }
+	static Vec zero() { return _mm512_setzero_pd(); }
+	static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+	static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+	static Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+	static Vec div(Vec a, Vec b) { return _mm512_div_pd(a, b); }
+	static Vec min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+	static Vec max(Vec a, Vec b) { return _mm512_max_pd(a, b); }
+	static Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_pd(a, b, c); }
+	static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm512_fnmadd_pd(a, b, c); }
+	static Vec round(Vec a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static Cmp greater(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+	static Cmp less(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+	static Vec blend(Cmp c, Vec ifTrue, Vec ifFalse) { return _mm512_mask_blend_pd(c, ifFalse, ifTrue); }
+	static Vec scale2(Vec y, Vec n) { return _mm512_scalef_pd(y, n); }
+	static Mask tailMask(int count) { return static_cast<Mask>((1u << count) - 1u); }
+	static Vec maskLoad(const Real* p, Mask m, Vec fill) { return _mm512_mask_loadu_pd(fill, m, p); }
+	static void maskStore(Real* p, Mask m, Vec v) { _mm512_mask_storeu_pd(p, m, v); }
+};
+
+template <typename RealType>
+struct Avx512Vector;
+
+template <>
+struct Avx512Vector<float> {
+	typedef Avx512Float type;
+};
+
+template <>
+struct Avx512Vector<double> {
+	typedef Avx512Double type;
+};
+
+} // namespace
+
+template <typename RealType>
+const SimdKernels<RealType>* getAvx512Kernels() {
+	static const SimdKernels<RealType> kernels =
+			KernelTable<typename Avx512Vector<RealType>::type>::make("avx512");
+	return &kernels;
+}
+
+} // namespace
+
+#else
+
+namespace bsccs {
+
+template <typename RealType>
+const SimdKernels<RealType>* getAvx512Kernels() {
+	return NULL; // Not compiled for AVX-512
+}
+
+} // namespace
+
+#endif
+
+namespace bsccs {
+
+template const SimdKernels<float>* getAvx512Kernels<float>();
+template const SimdKernels<double>* getAvx512Kernels<double>();
+
+} // namespace
@@ -8,6 +8,8 @@
 #ifndef COVARIATEPRIOR_H_
 #define COVARIATEPRIOR_H_
 
+#include <memory>
+
 #ifndef MY_RCPP_FLAG
 #define PI	3.14159265358979323851280895940618620443274267017841339111328125
 #else
@@ -21,6 +23,9 @@ namespace priors {
 typedef std::pair<double, double> GradientHessian;
 typedef std::vector<double> DoubleVector;
 
+class CovariatePrior;
+typedef std::shared_ptr<CovariatePrior> PriorPtr;
+
 class CovariatePrior {
 public:
 	CovariatePrior() {
@@ -42,6 +47,12 @@ public:
 
 	virtual double logDensity(const DoubleVector& vector) const = 0; // pure virtual
 
+	virtual PriorPtr clone() const = 0; // pure virtual
+
+	// A zero coefficient stays at zero whenever |gradient| <= threshold
+	virtual double getSparsityThreshold() const {
+		return 0.0;
+	}
 };
 
 class NoPrior : public CovariatePrior {
@@ -77,6 +88,10 @@ public:
 	double getDelta(GradientHessian gh, double beta) const {
 		return -(gh.first / gh.second); // No regularization
 	}
+
+	PriorPtr clone() const {
+		return std::make_shared<NoPrior>(*this);
+	}
 };
 
 class LaplacePrior : public CovariatePrior {
@@ -144,6 +159,14 @@ public:
 		return delta;
 	}
 
+	PriorPtr clone() const {
+		return std::make_shared<LaplacePrior>(*this);
+	}
+
+	double getSparsityThreshold() const {
+		return lambda;
+	}
+
 private:
 
 	template <typename Vector>
@@ -218,6 +241,10 @@ public:
 				  (gh.second + (1.0 / sigma2Beta));
 	}
 
+	PriorPtr clone() const {
+		return std::make_shared<NormalPrior>(*this);
+	}
+
 private:
 	double sigma2Beta;
 
@@ -238,8 +265,6 @@ private:
 	}
 };
 
-typedef std::shared_ptr<CovariatePrior> PriorPtr;
-
 } /* namespace priors */
 } /* namespace bsccs */
 #endif /* COVARIATEPRIOR_H_ */
@@ -8,6 +8,8 @@
 #ifndef JOINTPRIOR_H_
 #define JOINTPRIOR_H_
 
+#include <map>
+
 #include "CyclicCoordinateDescent.h"
 #include "priors/CovariatePrior.h"
 
@@ -16,6 +18,9 @@ namespace priors {
 
 typedef std::vector<double> DoubleVector;
 
+class JointPrior;
+typedef std::shared_ptr<JointPrior> JointPriorPtr;
+
 class JointPrior {
 public:
 	JointPrior() { }
@@ -30,6 +35,10 @@ public:
 	virtual double getDelta(const GradientHessian gh, const double beta, const int index) const = 0; // pure virtual
 
 	virtual const std::string getDescription() const = 0; // pure virtual
+
+	virtual JointPriorPtr clone() const = 0; // pure virtual
+
+	virtual double getSparsityThreshold(const int index) const = 0; // pure virtual
 };
 
 class MixtureJointPrior : public JointPrior {
@@ -75,6 +84,24 @@ public:
 		return listPriors[index]->getDelta(gh, beta);
 	}
 
+	double getSparsityThreshold(const int index) const {
+		return listPriors[index]->getSparsityThreshold();
+	}
+
+	JointPriorPtr clone() const {
+		// Deep copy, preserving which entries share the same prior
+		std::shared_ptr<MixtureJointPrior> copy = std::make_shared<MixtureJointPrior>(*this);
+		std::map<CovariatePrior*, PriorPtr> copied;
+		for (PriorList::iterator it = copy->listPriors.begin(); it != copy->listPriors.end(); ++it) {
+			PriorPtr& unique = copied[it->get()];
+			if (!unique) {
+				unique = (*it)->clone();
+			}
+			*it = unique;
+		}
+		return copy;
+	}
+
 private:
 	PriorList listPriors;
 
@@ -106,16 +133,26 @@ public:
 		return singlePrior->getDelta(gh, beta);
 	}
 
+	double getSparsityThreshold(const int index) const {
+		return singlePrior->getSparsityThreshold();
+	}
+
 	const std::string getDescription() const {
 		return singlePrior->getDescription();
 	}
 
+	JointPriorPtr clone() const {
+		return std::make_shared<FullyExchangeableJointPrior>(singlePrior->clone());
+	}
+
+	PriorPtr getPrior() const {
+		return singlePrior;
+	}
+
 private:
 	PriorPtr singlePrior;
 };
 
-typedef std::shared_ptr<JointPrior> JointPriorPtr;
-
 } /* namespace priors */
 } /* namespace bsccs */
 #endif /* JOINTPRIOR_H_ */